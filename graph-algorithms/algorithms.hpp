@@ -0,0 +1,197 @@
+#ifndef ALGORITHMS_H
+#define ALGORITHMS_H
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "../priority-heap/heap.hpp"
+
+// Distance of a node that can't be reached
+const long long UNREACHED = LLONG_MAX;
+
+/*
+ * Views of a graph for the algorithms to walk. Both hand every link out of
+ * a node with a positive weight to f(neighbor, weight). A dense view reads
+ * the rows of an adjacency matrix like Graph::getAdjMatrix() hands out,
+ * where 0 means no link. A CSR view reads row offsets, columns and weights
+ * like SparseGraph or a mapped CSR graph file.
+ */
+struct DenseView {
+  const int * const* matrix;
+  int numNodes;
+
+  template<typename F>
+  void forEachNeighbor(int u, F f) const {
+    const int *row = this->matrix[u];
+    for (int v = 0; v < this->numNodes; v++) {
+      if (row[v] > 0 && v != u) {  f(v, row[v]);  }
+    }
+  }
+};
+
+template<typename Offset>
+struct CsrView {
+  const Offset *offsets;
+  const int *columns;
+  const int *weights;
+  int numNodes;
+
+  template<typename F>
+  void forEachNeighbor(int u, F f) const {
+    for (Offset k = this->offsets[u]; k < this->offsets[u + 1]; k++) {
+      if (this->weights[k] > 0) {  f(this->columns[k], this->weights[k]);  }
+    }
+  }
+};
+
+// How much work a queue did over a run
+struct QueueStats {
+  long long pushes = 0;
+  long long pops = 0;
+  long long decreases = 0;
+};
+
+/*
+ * Queues of nodes keyed by tentative distance. They all have the same
+ * interface so the algorithms can be templated over them:
+ *   push(node, key)      node enters the queue
+ *   decrease(node, key)  node is in the queue and its key went down
+ *   pop(node, key)       takes the lowest key, false once empty
+ *
+ * AddressableQueue keeps one entry per node in an Addressable heap and
+ * updates it in place through the handle the heap gave it. LazyQueue never
+ * updates anything: a decrease pushes a second entry and the old one is
+ * left to be popped and thrown away later (the algorithms skip nodes they
+ * have already settled), trading a bigger heap for no position map.
+ */
+template<int Arity>
+class AddressableQueue {
+  private:
+    MinHeap<int, noTiebreak<int, long long>, Arity, true> heap;
+    std::vector<int> handles;
+  public:
+    QueueStats stats;
+
+    AddressableQueue(int numNodes) : heap(numNodes), handles(numNodes, -1) { }
+    void push(int node, long long key) {
+      this->handles[node] = this->heap.push(node, key);
+      this->stats.pushes++;
+    }
+    void decrease(int node, long long key) {
+      this->heap.update(this->handles[node], key);
+      this->stats.decreases++;
+    }
+    bool pop(int& node, long long& key) {
+      if (this->heap.isEmpty()) {  return false;  }
+      key = this->heap.popInto(node);
+      this->handles[node] = -1;
+      this->stats.pops++;
+      return true;
+    }
+};
+
+template<int Arity>
+class LazyQueue {
+  private:
+    MinHeap<int, noTiebreak<int, long long>, Arity> heap;
+  public:
+    QueueStats stats;
+
+    LazyQueue(int numNodes) : heap(numNodes) { }
+    void push(int node, long long key) {
+      this->heap.push(node, key);
+      this->stats.pushes++;
+    }
+    void decrease(int node, long long key) {
+      this->heap.push(node, key);
+      this->stats.pushes++;
+      this->stats.decreases++;
+    }
+    bool pop(int& node, long long& key) {
+      if (this->heap.isEmpty()) {  return false;  }
+      key = this->heap.popInto(node);
+      this->stats.pops++;
+      return true;
+    }
+};
+
+/* dijkstra:
+ * Shortest distances from the nearest of the sources to every node, the
+ * sources all starting at distance 0. Fills distance (UNREACHED for nodes
+ * that can't be reached) and parent (-1 for sources and unreached nodes)
+ * and returns how many nodes were reached.
+ */
+template<typename Queue, typename View>
+int dijkstra(const View& graph, const std::vector<int>& sources, Queue& q,
+             std::vector<long long>& distance, std::vector<int>& parent) {
+  distance.assign(graph.numNodes, UNREACHED);
+  parent.assign(graph.numNodes, -1);
+  std::vector<char> settled(graph.numNodes, 0);
+  for (int s : sources) {
+    if (distance[s] != 0) {
+      distance[s] = 0;
+      q.push(s, 0);
+    }
+  }
+
+  int reached = 0;
+  int u;
+  long long d;
+  while (q.pop(u, d)) {
+    if (settled[u]) {  continue;  }
+    settled[u] = 1;
+    reached++;
+    graph.forEachNeighbor(u, [&](int v, int weight) {
+      long long candidate = d + weight;
+      if (settled[v] || candidate >= distance[v]) {  return;  }
+      if (distance[v] == UNREACHED) {
+        q.push(v, candidate);
+      } else {
+        q.decrease(v, candidate);
+      }
+      distance[v] = candidate;
+      parent[v] = u;
+    });
+  }
+  return reached;
+}
+
+/* prim:
+ * Minimum spanning forest. Grows a tree from the lowest numbered node not
+ * yet in one until every node is, so a disconnected graph gets a tree per
+ * component. Fills parent (-1 for the root of each tree) and returns the
+ * total weight. Links are read from the row of the node being added, so
+ * the graph is expected to be symmetric.
+ */
+template<typename Queue, typename View>
+long long prim(const View& graph, Queue& q, std::vector<int>& parent) {
+  std::vector<long long> key(graph.numNodes, UNREACHED);
+  std::vector<char> inTree(graph.numNodes, 0);
+  parent.assign(graph.numNodes, -1);
+
+  long long total = 0;
+  for (int root = 0; root < graph.numNodes; root++) {
+    if (inTree[root]) {  continue;  }
+    key[root] = 0;
+    q.push(root, 0);
+    int u;
+    long long k;
+    while (q.pop(u, k)) {
+      if (inTree[u]) {  continue;  }
+      inTree[u] = 1;
+      total += k;
+      graph.forEachNeighbor(u, [&](int v, int weight) {
+        if (inTree[v] || weight >= key[v]) {  return;  }
+        if (key[v] == UNREACHED) {
+          q.push(v, weight);
+        } else {
+          q.decrease(v, weight);
+        }
+        key[v] = weight;
+        parent[v] = u;
+      });
+    }
+  }
+  return total;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "algorithms.hpp"
+
+// Random symmetric matrix where about a third of the pairs are linked
+std::vector<std::vector<int>> randomMatrix(int n, std::mt19937& mt) {
+  std::uniform_int_distribution<int> cost(-200, 100);
+  std::vector<std::vector<int>> m(n, std::vector<int>(n, 0));
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < i; j++) {
+      m[i][j] = m[j][i] = std::max(cost(mt), 0);
+    }
+  }
+  return m;
+}
+
+// Bellman-Ford from the sources, the slow and obviously right way
+std::vector<long long> slowDistances(const std::vector<std::vector<int>>& m, const std::vector<int>& sources) {
+  int n = m.size();
+  std::vector<long long> d(n, UNREACHED);
+  for (int s : sources) {  d[s] = 0;  }
+  for (int round = 0; round < n; round++) {
+    for (int u = 0; u < n; u++) {
+      for (int v = 0; v < n; v++) {
+        if (d[u] != UNREACHED && m[u][v] > 0 && d[u] + m[u][v] < d[v]) {  d[v] = d[u] + m[u][v];  }
+      }
+    }
+  }
+  return d;
+}
+
+// Kruskal with a plain union-find
+long long slowForestWeight(const std::vector<std::vector<int>>& m) {
+  int n = m.size();
+  std::vector<std::vector<int>> edges;
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < i; j++) {
+      if (m[i][j] > 0) {  edges.push_back({m[i][j], i, j});  }
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  std::vector<int> root(n);
+  std::iota(root.begin(), root.end(), 0);
+  auto find = [&](int x) {
+    while (root[x] != x) {  x = root[x] = root[root[x]];  }
+    return x;
+  };
+  long long total = 0;
+  for (auto& e : edges) {
+    int a = find(e[1]), b = find(e[2]);
+    if (a != b) {
+      root[a] = b;
+      total += e[0];
+    }
+  }
+  return total;
+}
+
+template<typename Queue>
+bool checkQueue(int graphs, std::mt19937& mt) {
+  bool same = true;
+  for (int g = 0; g < graphs; g++) {
+    int n = 1 + g % 40;
+    auto m = randomMatrix(n, mt);
+    std::vector<const int*> rows;
+    for (auto& row : m) {  rows.push_back(row.data());  }
+    DenseView view{rows.data(), n};
+
+    std::vector<int> sources = {static_cast<int>(mt() % n)};
+    if (g % 3 == 0) {  sources.push_back(mt() % n);  }
+    std::vector<long long> distance;
+    std::vector<int> parent;
+    Queue q(n);
+    dijkstra(view, sources, q, distance, parent);
+    same = same && distance == slowDistances(m, sources);
+
+    Queue treeQueue(n);
+    same = same && prim(view, treeQueue, parent) == slowForestWeight(m);
+  }
+  return same;
+}
+
+int main() {
+  std::mt19937 mt(130);
+  std::cout << "BINARY HEAP: " << (checkQueue<AddressableQueue<2>>(200, mt) ? "MATCHES" : "MISMATCH") << std::endl;
+  std::cout << "4-ARY HEAP: " << (checkQueue<AddressableQueue<4>>(200, mt) ? "MATCHES" : "MISMATCH") << std::endl;
+  std::cout << "8-ARY HEAP: " << (checkQueue<AddressableQueue<8>>(200, mt) ? "MATCHES" : "MISMATCH") << std::endl;
+  std::cout << "LAZY HEAP: " << (checkQueue<LazyQueue<2>>(200, mt) ? "MATCHES" : "MISMATCH") << std::endl;
+}
@@ -0,0 +1,187 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "algorithms.hpp"
+#include "../graph-generator/generator.hpp"
+#include "../graph-generator/graphfile.hpp"
+
+/*
+ * Runs Dijkstra or Prim over a generated or mapped graph with each of the
+ * selected queues and reports the run time and what the queue had to do.
+ * Every queue has to come up with the same distances (or the same tree
+ * weight), which is checked against the first one.
+ */
+
+const char *QUEUE_NAMES[] = {"heap", "dary4", "dary8", "lazy"};
+const int NUM_QUEUES = 4;
+
+struct RunResult {
+  double milliseconds;
+  QueueStats stats;
+  int reached;
+  long long checksum;
+  std::vector<long long> distance;
+};
+
+template<typename Queue, typename View>
+RunResult runWith(const View& graph, bool mst, const std::vector<int>& sources) {
+  RunResult result;
+  Queue q(graph.numNodes);
+  std::vector<int> parent;
+  auto start = std::chrono::steady_clock::now();
+  if (mst) {
+    result.checksum = prim(graph, q, parent);
+    result.reached = graph.numNodes;
+  } else {
+    result.reached = dijkstra(graph, sources, q, result.distance, parent);
+    result.checksum = 0;
+    for (long long d : result.distance) {
+      if (d != UNREACHED) {  result.checksum += d;  }
+    }
+  }
+  result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  result.stats = q.stats;
+  return result;
+}
+
+template<typename View>
+RunResult run(int queue, const View& graph, bool mst, const std::vector<int>& sources) {
+  switch (queue) {
+    case 0:
+      return runWith<AddressableQueue<2>>(graph, mst, sources);
+    case 1:
+      return runWith<AddressableQueue<4>>(graph, mst, sources);
+    case 2:
+      return runWith<AddressableQueue<8>>(graph, mst, sources);
+    default:
+      return runWith<LazyQueue<2>>(graph, mst, sources);
+  }
+}
+
+template<typename View>
+int report(const View& graph, bool mst, const std::vector<int>& sources, const std::vector<int>& queues) {
+  for (int s : sources) {
+    if (s < 0 || s >= graph.numNodes) {
+      std::cerr << "Source " << s << " is not a node" << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "queue,milliseconds,pushes,pops,decreases,stale_pops,reached,"
+            << (mst ? "tree_weight" : "distance_sum") << std::endl;
+  RunResult first;
+  bool agree = true;
+  for (size_t i = 0; i < queues.size(); i++) {
+    RunResult r = run(queues[i], graph, mst, sources);
+    std::cout << QUEUE_NAMES[queues[i]] << "," << r.milliseconds << "," << r.stats.pushes << ","
+              << r.stats.pops << "," << r.stats.decreases << "," << r.stats.pops - r.reached << ","
+              << r.reached << "," << r.checksum << std::endl;
+    if (i == 0) {
+      first = std::move(r);
+    } else {
+      agree = agree && r.checksum == first.checksum && r.distance == first.distance;
+    }
+  }
+  if (!agree) {
+    std::cerr << "The queues disagree on the result" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Parses a comma separated list of integers, e.g. "0,17,42"
+bool parseList(const char *text, std::vector<int>& out) {
+  out.clear();
+  while (*text != '\0') {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text) {  return false;  }
+    out.push_back(static_cast<int>(value));
+    text = end;
+    if (*text == ',') {  text++;  }
+    else if (*text != '\0') {  return false;  }
+  }
+  return !out.empty();
+}
+
+void usage() {
+  std::cout << "Usage: paths dijkstra|prim --nodes=<n> [--seed=<s>] [--degree=<d>] [options]" << std::endl
+            << "       paths dijkstra|prim --file=<binary graph> [options]" << std::endl
+            << "Options: --sources=<list> (default 0), --queue=heap|dary4|dary8|lazy|all (default all)" << std::endl;
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {  usage();  }
+  bool mst;
+  if (strcmp(argv[1], "dijkstra") == 0) {
+    mst = false;
+  } else if (strcmp(argv[1], "prim") == 0) {
+    mst = true;
+  } else {
+    usage();
+  }
+
+  int numNodes = -1;
+  int seed = 130;
+  double degree = -1;
+  const char *file = nullptr;
+  std::vector<int> sources(1, 0);
+  std::vector<int> queues = {0, 1, 2, 3};
+  for (int i = 2; i < argc; i++) {
+    bool ok = true;
+    if (strncmp(argv[i], "--nodes=", 8) == 0) {
+      numNodes = atoi(argv[i] + 8);
+    } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+      seed = atoi(argv[i] + 7);
+    } else if (strncmp(argv[i], "--degree=", 9) == 0) {
+      degree = atof(argv[i] + 9);
+    } else if (strncmp(argv[i], "--file=", 7) == 0) {
+      file = argv[i] + 7;
+    } else if (strncmp(argv[i], "--sources=", 10) == 0) {
+      ok = parseList(argv[i] + 10, sources);
+    } else if (strncmp(argv[i], "--queue=", 8) == 0) {
+      const char *name = argv[i] + 8;
+      queues.clear();
+      for (int q = 0; q < NUM_QUEUES; q++) {
+        if (strcmp(name, "all") == 0 || strcmp(name, QUEUE_NAMES[q]) == 0) {  queues.push_back(q);  }
+      }
+      ok = !queues.empty();
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "Bad argument: " << argv[i] << std::endl;
+      usage();
+    }
+  }
+
+  if (file != nullptr) {
+    MappedGraph mapped;
+    // The searches index their arrays by column, so check those as well
+    if (!mapped.open(file, true)) {
+      std::cerr << "Could not map a graph from " << file << std::endl;
+      return 1;
+    }
+    if (mapped.getLayout() == GRAPH_DENSE) {
+      return report(DenseView{mapped.getAdjMatrix(), mapped.getNumNodes()}, mst, sources, queues);
+    }
+    CsrView<uint64_t> view{mapped.getOffsets(), mapped.getColumns(), mapped.getWeights(), mapped.getNumNodes()};
+    return report(view, mst, sources, queues);
+  }
+
+  if (numNodes < 1) {  usage();  }
+  if (degree >= 0) {
+    SparseGraph g(numNodes, (numNodes > 1) ? degree / (numNodes - 1) : 0, seed);
+    CsrView<long long> view{g.getOffsets(), g.getColumns(), g.getWeights(), numNodes};
+    return report(view, mst, sources, queues);
+  }
+  // Version 2 matrices are symmetric, which Prim needs
+  Graph g(numNodes, seed, GENERATOR_PHILOX, std::thread::hardware_concurrency());
+  return report(DenseView{g.getAdjMatrix(), numNodes}, mst, sources, queues);
+}
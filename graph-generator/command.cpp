@@ -1,49 +1,176 @@
 #include <iostream>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <random>
+#include <thread>
+#include <unistd.h>
 
 #include "generator.hpp"
+#include "graphfile.hpp"
+#include "writer.hpp"
 
-char *lpad(char *text, int length, char padWith) {
-  char *padded = new char[length+1];
-  int textLength = strlen(text);
-  for (int i=0; i < length; i++) { 
-    if (i >= length - textLength) {
-      padded[i] = text[i - (length - textLength)];
+// Prints a matrix row with every entry right aligned in 3 characters and
+// followed by a space, all on one line. Entries from 0 to 999, which is
+// all the generator ever produces, are copied whole from a table of 
+// ready made cells
+void printRow(const int *row, int numNodes, Writer& out) {
+  static char cells[1000][4];
+  static bool filled = false;
+  if (!filled) {
+    for (int v = 0; v < 1000; v++) {
+      cells[v][0] = (v >= 100) ? '0' + v / 100 : ' ';
+      cells[v][1] = (v >= 10) ? '0' + v / 10 % 10 : ' ';
+      cells[v][2] = '0' + v % 10;
+      cells[v][3] = ' ';
+    }
+    filled = true;
+  }
+  for (int j = 0; j < numNodes; j++) {
+    if (row[j] >= 0 && row[j] < 1000) {
+      memcpy(out.reserve(4), cells[row[j]], 4);
+      out.commit(4);
     } else {
-      padded[i] = padWith;
+      out.putPadded(row[j], 3, ' ');
+      out.put(' ');
+    }
+  }
+  out.put('\n');
+}
+
+void printMatrix(const int * const* adjMatrix, int numNodes, Writer& out) {
+  for (int i = 0; i < numNodes; i++) {
+    printRow(adjMatrix[i], numNodes, out);
+  }
+}
+
+// Prints a sparse graph as an edge list: "n m" and then one "u v w" line
+// per undirected link, each link once with u < v
+void printEdgeList(const SparseGraph& g, Writer& out) {
+  const long long *offsets = g.getOffsets();
+  const int *columns = g.getColumns();
+  const int *weights = g.getWeights();
+  out.putInt(g.getNumNodes());
+  out.put(' ');
+  out.putInt(g.getNumEdges());
+  out.put('\n');
+  for (int i = 0; i < g.getNumNodes(); i++) {
+    for (long long k = offsets[i]; k < offsets[i + 1]; k++) {
+      if (columns[k] > i) {
+        out.putInt(i);
+        out.put(' ');
+        out.putInt(columns[k]);
+        out.put(' ');
+        out.putInt(weights[k]);
+        out.put('\n');
+      }
     }
   }
-  padded[length] = '\0';
-  return padded;
 }
 
 int main(int argc, char **argv) {
+  double degree = -1;
+  double probability = -1;
+  bool stats = false;
+  bool binary = false;
+  bool stream = false;
+  int version = 0;
+  int numThreads = std::thread::hardware_concurrency();
+  char *positional[2];
+  int numPositional = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--degree=", 9) == 0) {
+      degree = atof(argv[i] + 9);
+    } else if (strncmp(argv[i], "--probability=", 14) == 0) {
+      probability = atof(argv[i] + 14);
+    } else if (strncmp(argv[i], "--version=", 10) == 0) {
+      version = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+      numThreads = atoi(argv[i] + 10);
+    } else if (strcmp(argv[i], "--stream") == 0) {
+      stream = true;
+    } else if (strcmp(argv[i], "--binary") == 0) {
+      binary = true;
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+    } else if (numPositional < 2) {
+      positional[numPositional++] = argv[i];
+    } else {
+      numPositional++;
+    }
+  }
+
   int seed;
-  if (argc == 2) {
+  if (numPositional == 1) {
     seed = (std::random_device())();
-  } else if (argc == 3) {
-    seed = atoi(argv[2]);
+  } else if (numPositional == 2) {
+    seed = atoi(positional[1]);
   } else {
-    std::cout << "Usage: generate <num_nodes> [<seed>]" << std::endl;
+    std::cout << "Usage: generate <num_nodes> [<seed>] [--version=1|2] [--threads=<n>] [--stream] [--binary] [--stats]" << std::endl
+              << "       generate <num_nodes> [<seed>] --degree=<average_degree>|--probability=<edge_probability> [--binary] [--stats]" << std::endl;
+    exit(1);
+  }
+  // Only version 2 can make a row without the rest of the matrix, so 
+  // streaming defaults to it
+  if (version == 0) {
+    version = stream ? GENERATOR_PHILOX : GENERATOR_MT19937;
+  }
+  if (stream && (version != GENERATOR_PHILOX || degree >= 0 || probability >= 0)) {
+    std::cerr << "--stream only works for version 2 matrices" << std::endl;
+    exit(1);
+  }
+  if (version != GENERATOR_MT19937 && version != GENERATOR_PHILOX) {
+    std::cerr << "Unknown generator version: " << version << std::endl;
     exit(1);
   }
 
-  int numNodes = atoi(argv[1]);
-  Graph g(numNodes, seed);
-  const int * const* adjMatrix = g.getAdjMatrix();
-  for (int i = 0; i < numNodes; i++) {
-    for (int j = 0; j < numNodes; j++) {
-      char element[4];
-      sprintf(element, "%d", adjMatrix[i][j]);
-      char *padded = lpad(element, 3, ' ');
-      std::cout << padded << " "; 
-      delete[] padded;
+  // Asking for a degree or a probability switches to the sparse mode, 
+  // which prints an edge list instead of a matrix. --binary writes either
+  // one in the mmappable format of graphfile.hpp instead of as text.
+  // --stream prints a matrix as its rows are made instead of making the
+  // whole thing first
+  int numNodes = atoi(positional[0]);
+  Writer out(STDOUT_FILENO);
+  std::chrono::steady_clock::time_point start;
+  if (degree >= 0 || probability >= 0) {
+    if (probability < 0) {
+      probability = (numNodes > 1) ? degree / (numNodes - 1) : 0;
+    }
+    SparseGraph g(numNodes, probability, seed);
+    start = std::chrono::steady_clock::now();
+    if (binary) {
+      writeSparseGraphFile(g, out);
+    } else {
+      printEdgeList(g, out);
+    }
+  } else if (stream) {
+    GraphStream g(numNodes, seed, numThreads);
+    start = std::chrono::steady_clock::now();
+    if (binary) {
+      writeDenseGraphHeader(numNodes, out);
+      g.forEachRow([&](const int *row) { writeDenseGraphRow(row, numNodes, out); });
+    } else {
+      g.forEachRow([&](const int *row) { printRow(row, numNodes, out); });
+    }
+  } else {
+    Graph g(numNodes, seed, static_cast<GENERATOR_VERSION>(version), numThreads);
+    start = std::chrono::steady_clock::now();
+    if (binary) {
+      writeDenseGraphFile(g.getAdjMatrix(), numNodes, out);
+    } else {
+      printMatrix(g.getAdjMatrix(), numNodes, out);
     }
-    std::cout << std::endl;
   }
+  out.flush();
 
+  // Only the printing is timed, not generating the graph, except that a
+  // stream does both at once
+  if (stats) {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double bytes = static_cast<double>(out.getBytesWritten());
+    std::cerr << "wrote " << out.getBytesWritten() << " bytes in " << seconds << " s ("
+              << bytes / seconds / 1e9 << " GB/s)" << std::endl;
+  }
   return 0;
 }
 
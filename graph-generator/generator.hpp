@@ -1,11 +1,77 @@
 #ifndef GENERATOR_H
 #define GENERATOR_H
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
 #include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "philox.hpp"
+
+// The ways a Graph can be generated. Each version always produces the same
+// graph for the same seed, so a new way of generating gets a new version
+// instead of replacing an old one. Version 1 is the original sequential
+// mt19937 fill. Version 2 takes every cost from a counter-based generator,
+// so it can fill rows on any number of threads with the same result
+enum GENERATOR_VERSION {GENERATOR_MT19937 = 1, GENERATOR_PHILOX = 2};
 
 using mt1337 = std::mt19937; // Because I can
+
+// The Philox numbers of version 2, as a function of the seed and the pair
+// of nodes so they come out the same from either end
+inline int philoxValue(uint32_t seed, int i, int j, uint32_t stream, int min, int max) {
+  PhiloxBlock counter = {{static_cast<uint32_t>(std::min(i, j)), static_cast<uint32_t>(std::max(i, j)), stream, 0}};
+  return philoxRange(philox4x32(counter, seed, GENERATOR_PHILOX).v[0], min, max);
+}
+
+/* fillPhiloxRow:
+ * Fills row i of a version 2 matrix as it is before the fix-ups. Returns
+ * the node its fix-up link goes to, or -1 if it has a link and needs none.
+ */
+inline int fillPhiloxRow(uint32_t seed, int numNodes, int i, int* row) {
+  int max = -1337;
+  int maxIndex = -1;
+  for (int j = 0; j < numNodes; j++) {
+    if (i == j) {
+      row[j] = 0;
+      continue;
+    }
+    int cost = philoxValue(seed, i, j, 0, -120, 100);
+    if (cost > max) {
+      max = cost;
+      maxIndex = j;
+    }
+    row[j] = (cost > 0) ? cost : 0;
+  }
+  return (max <= 0) ? maxIndex : -1;
+}
+
+/* findPhiloxFixUp:
+ * What fillPhiloxRow returns, without the row. Nearly half of all costs
+ * are positive and the first one settles it, so this looks at a couple of
+ * entries per row on average and only scans the rows that do need a fix.
+ */
+inline int findPhiloxFixUp(uint32_t seed, int numNodes, int i) {
+  int max = -1337;
+  int maxIndex = -1;
+  for (int j = 0; j < numNodes; j++) {
+    if (i == j) { continue; }
+    int cost = philoxValue(seed, i, j, 0, -120, 100);
+    if (cost > 0) { return -1; }
+    if (cost > max) {
+      max = cost;
+      maxIndex = j;
+    }
+  }
+  return maxIndex;
+}
+
 class Graph {
   private:
     int** adjMatrix;
+    uint32_t seed;
     mt1337 mt;
     std::uniform_int_distribution<int> uniform;
     std::uniform_int_distribution<int> cost;
@@ -15,17 +81,28 @@ class Graph {
     int getRandCost() {
       return this->cost(this->mt);
     }
+    void generateMt19937(int numNodes);
+    void generatePhilox(int numNodes, int numThreads);
   public:
-    Graph(int numNodes, int seed);
+    Graph(int numNodes, int seed, GENERATOR_VERSION version = GENERATOR_MT19937, int numThreads = 1);
     const int* const* getAdjMatrix() const { return this->adjMatrix; }
     void changeNode(int i, int j, int newValue) {
       this->adjMatrix[i][j] = this->adjMatrix[j][i] = newValue;
     }
 };
 
-Graph::Graph(int numNodes, int seed) : uniform(1, 100), cost(-120, 100) {
-  this->mt.seed(seed);
+Graph::Graph(int numNodes, int seed, GENERATOR_VERSION version, int numThreads) 
+  : seed(seed), uniform(1, 100), cost(-120, 100) {
   this->adjMatrix = new int*[numNodes];
+  if (version == GENERATOR_PHILOX) {
+    this->generatePhilox(numNodes, numThreads);
+  } else {
+    this->generateMt19937(numNodes);
+  }
+}
+
+void Graph::generateMt19937(int numNodes) {
+  this->mt.seed(this->seed);
   for (int i = 0; i < numNodes; i++) {
     this->adjMatrix[i] = new int[numNodes];
   }
@@ -61,4 +138,263 @@ Graph::Graph(int numNodes, int seed) : uniform(1, 100), cost(-120, 100) {
     }
   }
 }
+
+/* generatePhilox:
+ * Same rules as the mt19937 version: costs from -120 to 100 with anything
+ * not positive meaning no link, and a node whose links all came out that
+ * way gets linked to the node of its highest cost with a cost from 1 to
+ * 100. Unlike there, that fix-up link is set in both rows, so the matrix
+ * is always symmetric.
+ *
+ * Threads take every numThreads-th row, fill it and note any node that
+ * needs a fix-up. Once they are done the fix-ups are applied, which only
+ * touches a handful of entries.
+ */
+void Graph::generatePhilox(int numNodes, int numThreads) {
+  std::vector<int> pick(numNodes, -1);
+  auto fillRows = [&](int first) {
+    for (int i = first; i < numNodes; i += numThreads) {
+      this->adjMatrix[i] = new int[numNodes];
+      pick[i] = fillPhiloxRow(this->seed, numNodes, i, this->adjMatrix[i]);
+    }
+  };
+
+  numThreads = std::max(1, std::min(numThreads, numNodes));
+  std::vector<std::thread> threads;
+  for (int t = 1; t < numThreads; t++) {
+    threads.emplace_back(fillRows, t);
+  }
+  fillRows(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < numNodes; i++) {
+    if (pick[i] != -1) {
+      this->changeNode(i, pick[i], philoxValue(this->seed, i, pick[i], 1, 1, 100));
+    }
+  }
+}
+
+/*
+ * Version 2 matrix a few rows at a time, for when the whole n x n matrix
+ * doesn't fit or isn't wanted. The rows come out exactly as Graph makes
+ * them, fix-ups and all, but only numThreads of them are held at once.
+ *
+ * The fix-ups are what make a row depend on the others: node i's fix-up
+ * link also shows up in the row of the node it goes to. So the
+ * constructor first finds every node that needs one, which is cheap (see
+ * findPhiloxFixUp), and keeps both ends of each fix-up link sorted by row.
+ * Apart from the rows that is the only memory used, O(n) at worst and next
+ * to nothing in practice.
+ */
+class GraphStream {
+  private:
+    int numNodes;
+    uint32_t seed;
+    int numThreads;
+    // (row, column) of both ends of every fix-up link, in row order
+    std::vector<std::pair<int, int>> fixUps;
+  public:
+    GraphStream(int numNodes, int seed, int numThreads = 1);
+    int getNumNodes() const { return this->numNodes; }
+
+    // Calls emit(row) with every row in order. Each batch of numThreads 
+    // rows is filled in parallel, and a row only lives until emit returns
+    template<typename Emit>
+    void forEachRow(Emit emit);
+};
+
+GraphStream::GraphStream(int numNodes, int seed, int numThreads) 
+  : numNodes(numNodes), seed(seed), numThreads(std::max(1, std::min(numThreads, numNodes))) {
+  for (int i = 0; i < numNodes; i++) {
+    int pick = findPhiloxFixUp(this->seed, numNodes, i);
+    if (pick != -1) {
+      this->fixUps.push_back(std::make_pair(i, pick));
+      this->fixUps.push_back(std::make_pair(pick, i));
+    }
+  }
+  std::sort(this->fixUps.begin(), this->fixUps.end());
+}
+
+template<typename Emit>
+void GraphStream::forEachRow(Emit emit) {
+  std::vector<int> rows(static_cast<size_t>(this->numThreads) * this->numNodes);
+  auto fillRow = [&](int i) {
+    fillPhiloxRow(this->seed, this->numNodes, i, rows.data() + static_cast<size_t>(i % this->numThreads) * this->numNodes);
+  };
+
+  // The workers live for the whole stream. Worker w fills row first + w of
+  // every batch; bumping batch starts them on the next one, and the last to
+  // finish wakes the caller. first past the end tells them to stop
+  std::mutex mutex;
+  std::condition_variable start, done;
+  int first = 0;
+  long long batch = 0;
+  int pending = 0;
+  auto work = [&](int w) {
+    long long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      start.wait(lock, [&] {  return batch != seen;  });
+      seen = batch;
+      if (first >= this->numNodes) {  return;  }
+      int i = first + w;
+      lock.unlock();
+      if (i < this->numNodes) {  fillRow(i);  }
+      lock.lock();
+      if (--pending == 0) {  done.notify_one();  }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int w = 1; w < this->numThreads; w++) {
+    threads.emplace_back(work, w);
+  }
+
+  size_t nextFixUp = 0;
+  while (first < this->numNodes) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending = this->numThreads - 1;
+      batch++;
+    }
+    start.notify_all();
+    fillRow(first);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [&] {  return pending == 0;  });
+    }
+
+    int last = std::min(first + this->numThreads, this->numNodes);
+    for (int i = first; i < last; i++) {
+      int* row = rows.data() + static_cast<size_t>(i % this->numThreads) * this->numNodes;
+      for (; nextFixUp < this->fixUps.size() && this->fixUps[nextFixUp].first == i; nextFixUp++) {
+        int j = this->fixUps[nextFixUp].second;
+        row[j] = philoxValue(this->seed, i, j, 1, 1, 100);
+      }
+      emit(static_cast<const int*>(row));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    first = last;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    batch++;
+  }
+  start.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+/*
+ * Sparse counterpart of Graph for node counts where an n x n matrix won't
+ * fit. Every pair of nodes is linked with the given probability, like a
+ * matrix entry coming out positive, but the pairs that don't get a link
+ * are skipped over with geometrically distributed jumps instead of being
+ * visited one by one, so generating takes O(n + m) time and memory. Links
+ * get a cost from 1 to 100 and a node that ends up with no links at all is
+ * linked to a random other node, the same guarantees Graph gives.
+ *
+ * The result is kept in compressed sparse row form: the links of node i
+ * are entries offsets[i] up to offsets[i+1] of columns and weights. Every
+ * link shows up in the rows of both its ends with the same weight. The
+ * offsets are 64 bit since a big enough graph has more than 2^31 entries.
+ */
+class SparseGraph {
+  private:
+    int numNodes;
+    std::vector<long long> offsets;
+    std::vector<int> columns;
+    std::vector<int> weights;
+    mt1337 mt;
+    std::uniform_int_distribution<int> uniform;
+    std::uniform_real_distribution<double> unit;
+
+    struct Edge {
+      int u;
+      int v;
+      int weight;
+    };
+    int getRandUniform() {
+      return this->uniform(this->mt);
+    }
+  public:
+    SparseGraph(int numNodes, double edgeProbability, int seed);
+    int getNumNodes() const { return this->numNodes; }
+    // Each undirected link counts once
+    long long getNumEdges() const { return static_cast<long long>(this->columns.size()) / 2; }
+    const long long* getOffsets() const { return this->offsets.data(); }
+    const int* getColumns() const { return this->columns.data(); }
+    const int* getWeights() const { return this->weights.data(); }
+};
+
+SparseGraph::SparseGraph(int numNodes, double edgeProbability, int seed) 
+  : numNodes(numNodes), uniform(1, 100), unit(0.0, 1.0) {
+  this->mt.seed(seed);
+  std::vector<Edge> edges;
+  std::vector<char> linked(numNodes, 0);
+
+  // Walks the pairs (v, w) with w < v in order, jumping ahead by a 
+  // geometric number of pairs each time (Batagelj and Brandes, 2005)
+  if (edgeProbability >= 1.0) {
+    for (int v = 1; v < numNodes; v++) {
+      for (int w = 0; w < v; w++) {
+        edges.push_back(Edge{v, w, this->getRandUniform()});
+      }
+    }
+  } else if (edgeProbability > 0.0) {
+    edges.reserve(static_cast<size_t>(edgeProbability * numNodes * (numNodes - 1) / 2 * 1.01) + 16);
+    double logMiss = std::log(1.0 - edgeProbability);
+    long long v = 1;
+    long long w = -1;
+    while (v < numNodes) {
+      w += 1 + static_cast<long long>(std::floor(std::log(1.0 - this->unit(this->mt)) / logMiss));
+      while (w >= v && v < numNodes) {
+        w -= v;
+        v++;
+      }
+      if (v < numNodes) {
+        edges.push_back(Edge{static_cast<int>(v), static_cast<int>(w), this->getRandUniform()});
+      }
+    }
+  }
+
+  for (Edge& e : edges) {
+    linked[e.u] = linked[e.v] = 1;
+  }
+  if (numNodes > 1) {
+    std::uniform_int_distribution<int> other(0, numNodes - 2);
+    for (int i = 0; i < numNodes; i++) {
+      if (!linked[i]) {
+        int j = other(this->mt);
+        if (j >= i) { j++; }
+        edges.push_back(Edge{i, j, this->getRandUniform()});
+        linked[i] = linked[j] = 1;
+      }
+    }
+  }
+
+  // Counting sort of both directions of every link into rows
+  this->offsets.assign(numNodes + 1, 0);
+  for (Edge& e : edges) {
+    this->offsets[e.u + 1]++;
+    this->offsets[e.v + 1]++;
+  }
+  for (int i = 0; i < numNodes; i++) {
+    this->offsets[i + 1] += this->offsets[i];
+  }
+  this->columns.resize(2 * edges.size());
+  this->weights.resize(2 * edges.size());
+  std::vector<long long> next(this->offsets.begin(), this->offsets.end() - 1);
+  for (Edge& e : edges) {
+    long long forward = next[e.u]++;
+    this->columns[forward] = e.v;
+    this->weights[forward] = e.weight;
+    long long backward = next[e.v]++;
+    this->columns[backward] = e.u;
+    this->weights[backward] = e.weight;
+  }
+}
 #endif // GENERATOR_H
@@ -0,0 +1,250 @@
+#ifndef GRAPHFILE_H
+#define GRAPHFILE_H
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "generator.hpp"
+#include "writer.hpp"
+
+/*
+ * Binary graph files, meant to be mmapped and used in place rather than
+ * parsed. A file is a 64 byte header followed by its arrays, each one
+ * starting on a 64 byte boundary:
+ *
+ *   dense: weights  n * n int32, row by row, 0 meaning no link
+ *   csr:   offsets  n + 1 uint64, the links of node i being entries
+ *                   offsets[i] up to offsets[i+1] of the next two
+ *          columns  int32 per link, the other end
+ *          weights  int32 per link
+ *
+ * The header records where each array starts. Everything is in the byte
+ * order of the machine that wrote the file, and the loader refuses files
+ * from a machine of the other order.
+ */
+enum GRAPH_LAYOUT {GRAPH_DENSE = 0, GRAPH_CSR = 1};
+
+const char GRAPH_FILE_MAGIC[8] = {'G', 'R', 'A', 'P', 'H', 'B', 'I', 'N'};
+const uint32_t GRAPH_FILE_VERSION = 1;
+const uint32_t GRAPH_FILE_BYTE_ORDER = 0x01020304;
+const uint64_t GRAPH_FILE_ALIGNMENT = 64;
+
+struct GraphFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t layout;
+  uint32_t reserved;
+  uint64_t numNodes;
+  // n * n for a dense graph, the number of links in both directions for CSR
+  uint64_t numEntries;
+  // Byte offsets of the arrays in the file, 0 if the layout has none
+  uint64_t offsetsAt;
+  uint64_t columnsAt;
+  uint64_t weightsAt;
+};
+static_assert(sizeof(GraphFileHeader) == 64, "graph file header has to be 64 bytes");
+
+inline uint64_t alignGraphSection(uint64_t at) {
+  return (at + GRAPH_FILE_ALIGNMENT - 1) / GRAPH_FILE_ALIGNMENT * GRAPH_FILE_ALIGNMENT;
+}
+
+inline GraphFileHeader makeGraphHeader(GRAPH_LAYOUT layout, uint64_t numNodes, uint64_t numEntries) {
+  GraphFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, GRAPH_FILE_MAGIC, 8);
+  header.version = GRAPH_FILE_VERSION;
+  header.byteOrder = GRAPH_FILE_BYTE_ORDER;
+  header.layout = layout;
+  header.numNodes = numNodes;
+  header.numEntries = numEntries;
+  return header;
+}
+
+// Pads the output with zeros up to the next array boundary. The file has
+// to start at the beginning of the writer for this to line up
+inline void padGraphSection(Writer& out) {
+  static const char zeros[GRAPH_FILE_ALIGNMENT] = {0};
+  uint64_t at = out.getBytesWritten();
+  out.put(zeros, alignGraphSection(at) - at);
+}
+
+// A dense file is its header followed by the rows as they are, so it can
+// also be written a row at a time
+inline void writeDenseGraphHeader(int numNodes, Writer& out) {
+  uint64_t n = numNodes;
+  GraphFileHeader header = makeGraphHeader(GRAPH_DENSE, n, n * n);
+  header.weightsAt = alignGraphSection(sizeof(header));
+  out.put(reinterpret_cast<const char*>(&header), sizeof(header));
+  padGraphSection(out);
+}
+
+inline void writeDenseGraphRow(const int* row, int numNodes, Writer& out) {
+  out.put(reinterpret_cast<const char*>(row), static_cast<size_t>(numNodes) * sizeof(int));
+}
+
+inline void writeDenseGraphFile(const int * const* adjMatrix, int numNodes, Writer& out) {
+  writeDenseGraphHeader(numNodes, out);
+  for (int i = 0; i < numNodes; i++) {
+    writeDenseGraphRow(adjMatrix[i], numNodes, out);
+  }
+}
+
+inline void writeSparseGraphFile(const SparseGraph& g, Writer& out) {
+  uint64_t n = g.getNumNodes();
+  const long long *offsets = g.getOffsets();
+  uint64_t numEntries = offsets[n];
+  GraphFileHeader header = makeGraphHeader(GRAPH_CSR, n, numEntries);
+  header.offsetsAt = alignGraphSection(sizeof(header));
+  header.columnsAt = alignGraphSection(header.offsetsAt + (n + 1) * sizeof(uint64_t));
+  header.weightsAt = alignGraphSection(header.columnsAt + numEntries * sizeof(int));
+
+  out.put(reinterpret_cast<const char*>(&header), sizeof(header));
+  padGraphSection(out);
+  for (uint64_t i = 0; i <= n; i++) {
+    uint64_t offset = offsets[i];
+    out.put(reinterpret_cast<const char*>(&offset), sizeof(offset));
+  }
+  padGraphSection(out);
+  out.put(reinterpret_cast<const char*>(g.getColumns()), numEntries * sizeof(int));
+  padGraphSection(out);
+  out.put(reinterpret_cast<const char*>(g.getWeights()), numEntries * sizeof(int));
+}
+
+/*
+ * Read only view of a binary graph file. open maps the file and checks the
+ * header, and the getters hand out pointers straight into the mapping, so
+ * nothing is read from disk until it is used. A dense graph gets an array
+ * of row pointers to look like Graph::getAdjMatrix(), which is the only
+ * thing built on open.
+ *
+ * For a CSR graph open also walks the offsets, which must start at 0, never
+ * go down and end at the number of entries. The columns are trusted unless
+ * open is asked to check them too, since that reads the whole array; code
+ * that indexes by column into anything of its own should ask.
+ */
+class MappedGraph {
+  private:
+    char* data;
+    size_t length;
+    GraphFileHeader header;
+    std::vector<const int*> rows;
+
+    bool fits(uint64_t at, uint64_t bytes) const {
+      return at % GRAPH_FILE_ALIGNMENT == 0 && at <= this->length && bytes <= this->length - at;
+    }
+    bool checkHeader() const;
+    bool checkColumns() const;
+  public:
+    MappedGraph() : data(nullptr), length(0) { }
+    MappedGraph(const MappedGraph&) = delete;
+    MappedGraph& operator=(const MappedGraph&) = delete;
+    ~MappedGraph() { this->close(); }
+
+    // Returns false if the file can't be mapped or isn't a valid graph file
+    bool open(const char* path, bool checkColumns = false);
+    void close();
+
+    GRAPH_LAYOUT getLayout() const { return static_cast<GRAPH_LAYOUT>(this->header.layout); }
+    int getNumNodes() const { return static_cast<int>(this->header.numNodes); }
+    long long getNumEntries() const { return static_cast<long long>(this->header.numEntries); }
+
+    // Dense graphs only
+    const int* const* getAdjMatrix() const { return this->rows.data(); }
+    // CSR graphs only
+    const uint64_t* getOffsets() const { return reinterpret_cast<const uint64_t*>(this->data + this->header.offsetsAt); }
+    const int* getColumns() const { return reinterpret_cast<const int*>(this->data + this->header.columnsAt); }
+    const int* getWeights() const { return reinterpret_cast<const int*>(this->data + this->header.weightsAt); }
+};
+
+inline bool MappedGraph::open(const char* path, bool checkColumns) {
+  this->close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) { return false; }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(GraphFileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  this->length = info.st_size;
+  void* mapped = mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    this->length = 0;
+    return false;
+  }
+  this->data = static_cast<char*>(mapped);
+  memcpy(&this->header, this->data, sizeof(this->header));
+  if (!this->checkHeader() || (checkColumns && !this->checkColumns())) {
+    this->close();
+    return false;
+  }
+
+  if (this->getLayout() == GRAPH_DENSE) {
+    const int* matrix = reinterpret_cast<const int*>(this->data + this->header.weightsAt);
+    this->rows.resize(this->header.numNodes);
+    for (uint64_t i = 0; i < this->header.numNodes; i++) {
+      this->rows[i] = matrix + i * this->header.numNodes;
+    }
+  }
+  return true;
+}
+
+inline void MappedGraph::close() {
+  if (this->data != nullptr) {
+    munmap(this->data, this->length);
+  }
+  this->data = nullptr;
+  this->length = 0;
+  this->rows.clear();
+}
+
+// Checks that the header is ours, every array lies inside the file and
+// the CSR offsets run in order from 0 to the number of entries
+inline bool MappedGraph::checkHeader() const {
+  const GraphFileHeader& h = this->header;
+  if (memcmp(h.magic, GRAPH_FILE_MAGIC, 8) != 0 || h.version != GRAPH_FILE_VERSION ||
+      h.byteOrder != GRAPH_FILE_BYTE_ORDER || h.numNodes > 0x7fffffffULL || h.numEntries > this->length) {
+    return false;
+  }
+  if (h.layout == GRAPH_DENSE) {
+    return h.numEntries == h.numNodes * h.numNodes && this->fits(h.weightsAt, h.numEntries * sizeof(int));
+  }
+  if (h.layout == GRAPH_CSR) {
+    if (!this->fits(h.offsetsAt, (h.numNodes + 1) * sizeof(uint64_t)) ||
+        !this->fits(h.columnsAt, h.numEntries * sizeof(int)) ||
+        !this->fits(h.weightsAt, h.numEntries * sizeof(int))) {
+      return false;
+    }
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(this->data + h.offsetsAt);
+    if (offsets[0] != 0 || offsets[h.numNodes] != h.numEntries) {
+      return false;
+    }
+    for (uint64_t i = 0; i < h.numNodes; i++) {
+      if (offsets[i] > offsets[i + 1]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+// Checks that every CSR column names a node of the graph
+inline bool MappedGraph::checkColumns() const {
+  if (this->getLayout() != GRAPH_CSR) {
+    return true;
+  }
+  const int* columns = this->getColumns();
+  for (uint64_t i = 0; i < this->header.numEntries; i++) {
+    if (columns[i] < 0 || static_cast<uint64_t>(columns[i]) >= this->header.numNodes) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#endif // GRAPHFILE_H
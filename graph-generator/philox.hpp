@@ -0,0 +1,46 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+#include <cstdint>
+
+/*
+ * Philox4x32-10 counter-based random number generator (Salmon et al.,
+ * "Parallel Random Numbers: As Easy as 1, 2, 3", 2011). Instead of
+ * stepping a state forward it scrambles a 128 bit counter under a 64 bit
+ * key, so the numbers for any counter can be computed directly, in any
+ * order and on any thread. Matches the Random123 reference output.
+ */
+struct PhiloxBlock {
+  uint32_t v[4];
+};
+
+inline PhiloxBlock philox4x32(PhiloxBlock counter, uint32_t key0, uint32_t key1) {
+  const uint32_t M0 = 0xD2511F53u;
+  const uint32_t M1 = 0xCD9E8D57u;
+  const uint32_t W0 = 0x9E3779B9u;
+  const uint32_t W1 = 0xBB67AE85u;
+  uint32_t* x = counter.v;
+  for (int round = 0; round < 10; round++) {
+    uint64_t p0 = static_cast<uint64_t>(M0) * x[0];
+    uint64_t p1 = static_cast<uint64_t>(M1) * x[2];
+    uint32_t y0 = static_cast<uint32_t>(p1 >> 32) ^ x[1] ^ key0;
+    uint32_t y1 = static_cast<uint32_t>(p1);
+    uint32_t y2 = static_cast<uint32_t>(p0 >> 32) ^ x[3] ^ key1;
+    uint32_t y3 = static_cast<uint32_t>(p0);
+    x[0] = y0;
+    x[1] = y1;
+    x[2] = y2;
+    x[3] = y3;
+    key0 += W0;
+    key1 += W1;
+  }
+  return counter;
+}
+
+// Maps 32 random bits onto min..max by scaling. The bias is below
+// (max - min + 1) / 2^32, far too small to matter for graph costs
+inline int philoxRange(uint32_t bits, int min, int max) {
+  uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(max) - min + 1);
+  return min + static_cast<int>((bits * span) >> 32);
+}
+
+#endif // PHILOX_H
@@ -0,0 +1,110 @@
+#ifndef WRITER_H
+#define WRITER_H
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+/*
+ * Output buffer for printing huge graphs. Text is formatted straight into
+ * one reusable buffer, integers included, and goes out in write() calls of
+ * a whole buffer at a time. Nothing is allocated after construction and
+ * nothing is flushed until the buffer fills up or flush is called.
+ */
+class Writer {
+  private:
+    int fd;
+    char* buffer;
+    size_t capacity;
+    size_t used;
+    long long bytesWritten;
+
+    void drain() {
+      size_t done = 0;
+      while (done < this->used) {
+        ssize_t written = ::write(this->fd, this->buffer + done, this->used - done);
+        if (written < 0 && errno == EINTR) { continue; }
+        if (written <= 0) { break; }
+        done += written;
+      }
+      this->bytesWritten += done;
+      this->used = 0;
+    }
+  public:
+    // The largest single put has to fit, so the buffer is at least 64 bytes
+    Writer(int fd, size_t capacity = 1 << 20) : fd(fd), capacity(capacity < 64 ? 64 : capacity), used(0), bytesWritten(0) {
+      this->buffer = new char[this->capacity];
+    }
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer() {
+      this->flush();
+      delete[] this->buffer;
+    }
+
+    // Room for at least n more bytes, n no bigger than the capacity
+    char* reserve(size_t n) {
+      if (this->used + n > this->capacity) { this->drain(); }
+      return this->buffer + this->used;
+    }
+    void commit(size_t n) { this->used += n; }
+
+    void put(char c) {
+      *this->reserve(1) = c;
+      this->used++;
+    }
+    void put(const char* text, size_t length);
+    void putInt(long long value);
+    // Right aligns the value in width characters like the old lpad did,
+    // keeping only the last width characters if it is too long
+    void putPadded(long long value, int width, char padWith);
+
+    void flush() { this->drain(); }
+    long long getBytesWritten() const { return this->bytesWritten + this->used; }
+};
+
+// Writes the decimal digits of value backwards from end and returns where
+// they start
+inline char* formatInt(long long value, char* end) {
+  unsigned long long magnitude = (value < 0) ? 0ULL - static_cast<unsigned long long>(value) : value;
+  char* p = end;
+  do {
+    *--p = '0' + static_cast<char>(magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) { *--p = '-'; }
+  return p;
+}
+
+inline void Writer::put(const char* text, size_t length) {
+  while (length > 0) {
+    size_t chunk = (length < this->capacity) ? length : this->capacity;
+    memcpy(this->reserve(chunk), text, chunk);
+    this->used += chunk;
+    text += chunk;
+    length -= chunk;
+  }
+}
+
+inline void Writer::putInt(long long value) {
+  char digits[24];
+  char* start = formatInt(value, digits + sizeof(digits));
+  size_t length = digits + sizeof(digits) - start;
+  memcpy(this->reserve(length), start, length);
+  this->used += length;
+}
+
+inline void Writer::putPadded(long long value, int width, char padWith) {
+  char digits[24];
+  char* start = formatInt(value, digits + sizeof(digits));
+  int length = static_cast<int>(digits + sizeof(digits) - start);
+  char* out = this->reserve(width);
+  if (length >= width) {
+    memcpy(out, start + (length - width), width);
+  } else {
+    memset(out, padWith, width - length);
+    memcpy(out + (width - length), start, length);
+  }
+  this->used += width;
+}
+
+#endif // WRITER_H
@@ -0,0 +1,102 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/*
+ * Bump allocator for short-lived data structures. Memory is carved out of 
+ * large chunks by moving a pointer forward and is only ever given back all
+ * at once, when the arena is reset or destroyed. Individual deallocations 
+ * are ignored, which makes this a good fit for queues that live for one 
+ * run and are thrown away, and a poor one for anything long-lived that 
+ * resizes a lot.
+ */
+class Arena {
+  private:
+    struct Chunk {
+      Chunk *next;
+      std::size_t size;
+    };
+
+    std::size_t chunkSize;
+    Chunk *chunks;
+    char *current;
+    std::size_t remaining;
+
+    void addChunk(std::size_t minimum);
+  public:
+    Arena(std::size_t chunkSize = 1 << 20) 
+      : chunkSize(chunkSize), chunks(nullptr), current(nullptr), remaining(0) { }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() {  this->reset();  }
+
+    void *allocate(std::size_t bytes, std::size_t alignment);
+    void reset();
+};
+
+// Gets a fresh chunk big enough for at least minimum bytes (plus room 
+// to align them). Whatever was left in the old chunk is abandoned
+inline void Arena::addChunk(std::size_t minimum) {
+  std::size_t size = (minimum + alignof(std::max_align_t) > this->chunkSize) 
+                     ? minimum + alignof(std::max_align_t) : this->chunkSize;
+  char *memory = static_cast<char *>(::operator new(sizeof(Chunk) + size));
+  Chunk *chunk = reinterpret_cast<Chunk *>(memory);
+  chunk->next = this->chunks;
+  chunk->size = size;
+  this->chunks = chunk;
+  this->current = memory + sizeof(Chunk);
+  this->remaining = size;
+}
+
+inline void *Arena::allocate(std::size_t bytes, std::size_t alignment) {
+  std::uintptr_t address = reinterpret_cast<std::uintptr_t>(this->current);
+  std::size_t padding = (alignment - address % alignment) % alignment;
+  if (this->current == nullptr || padding + bytes > this->remaining) {
+    this->addChunk(bytes + alignment);
+    address = reinterpret_cast<std::uintptr_t>(this->current);
+    padding = (alignment - address % alignment) % alignment;
+  }
+  void *result = this->current + padding;
+  this->current += padding + bytes;
+  this->remaining -= padding + bytes;
+  return result;
+}
+
+// Frees every chunk at once
+inline void Arena::reset() {
+  while (this->chunks != nullptr) {
+    Chunk *next = this->chunks->next;
+    ::operator delete(this->chunks);
+    this->chunks = next;
+  }
+  this->current = nullptr;
+  this->remaining = 0;
+}
+
+/*
+ * Standard allocator interface on top of an Arena, so it can be handed to 
+ * Heap or PriorityQueue. Copies (including rebound ones) share the arena.
+ */
+template<typename T>
+class ArenaAllocator {
+  public:
+    typedef T value_type;
+    Arena *arena;
+
+    ArenaAllocator(Arena& arena) : arena(&arena) { }
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) { }
+
+    T *allocate(std::size_t n) {
+      return static_cast<T *>(this->arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, std::size_t) { }
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {  return lhs.arena == rhs.arena;  }
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {  return lhs.arena != rhs.arena;  }
+#endif
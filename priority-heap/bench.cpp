@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <stdlib.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "heap.hpp"
+#include "simulator.hpp"
+
+/*
+ * Benchmarks the heap against std::priority_queue. Every combination of
+ * queue, payload, workload and size is run a few times untimed to warm up
+ * and then timed over a number of repetitions, and the spread of those
+ * repetitions is written out as CSV or JSON, in nanoseconds per operation.
+ *
+ * Workloads, all over the same keys for every queue:
+ *   push    n pushes into an empty queue
+ *   pop     n pops out of a queue filled with n elements beforehand
+ *   mixed   the hold model: n times pop the top and push it back a random
+ *           distance later, on a queue that holds n elements throughout
+ *   inckey  n random priority increases on a queue of n elements, then
+ *           draining it. The heap updates through its handles while
+ *           std::priority_queue has to push a second entry and skip the
+ *           stale one when it comes out, which is how it gets used for
+ *           this in practice
+ */
+
+enum QUEUE_KIND {QUEUE_HEAP, QUEUE_DARY4, QUEUE_STD};
+enum PAYLOAD_KIND {PAYLOAD_INT, PAYLOAD_EVENT, PAYLOAD_STRING};
+enum WORKLOAD {WORK_PUSH, WORK_POP, WORK_MIXED, WORK_INCKEY};
+
+const char *QUEUE_NAMES[] = {"heap", "dary4", "std"};
+const char *PAYLOAD_NAMES[] = {"int", "event", "string"};
+const char *WORKLOAD_NAMES[] = {"push", "pop", "mixed", "inckey"};
+
+// Keeps the compiler from throwing the popped elements away
+volatile long long sink;
+
+/*
+ * The inputs of a run, made before anything is timed. keys are the
+ * priorities pushed, steps the amounts added in mixed and inckey and
+ * targets the elements inckey picks
+ */
+struct Inputs {
+  std::vector<long long> keys;
+  std::vector<long long> steps;
+  std::vector<int> targets;
+};
+
+Inputs makeInputs(int n, unsigned long long seed) {
+  std::mt19937_64 mt(seed);
+  Inputs in;
+  in.keys.resize(n);
+  in.steps.resize(n);
+  in.targets.resize(n);
+  for (int i = 0; i < n; i++) {
+    in.keys[i] = mt() % (1LL << 40);
+    in.steps[i] = 1 + mt() % (1LL << 20);
+    in.targets[i] = mt() % n;
+  }
+  return in;
+}
+
+// Payloads, a string being long enough not to fit in the small string buffer
+void makePayload(int i, int& out) {  out = i;  }
+void makePayload(int i, Event& out) {  out = Event{DEPLOY_ATTACK, i, i + 1, -1, 0};  }
+void makePayload(int i, std::string& out) {  out = "computer-" + std::to_string(i) + "-payload-padding";  }
+
+template<typename Payload>
+std::vector<Payload> makePayloads(int n) {
+  std::vector<Payload> payloads(n);
+  for (int i = 0; i < n; i++) {  makePayload(i, payloads[i]);  }
+  return payloads;
+}
+
+/*
+ * Adapters giving every queue the same interface for the workloads:
+ *   push(key, id, payload)  adds an element, id being its index in the inputs
+ *   pop()                   removes the top and returns its key
+ *   increase(id, key, p)    raises the priority of element id, holding
+ *                           payload p, to key
+ *   track(n)                called before filling a queue inckey will use
+ *   isEmpty()
+ */
+// Only inckey needs handles, the other workloads run on the plain heap
+template<typename Payload, int Arity, bool Addressable>
+class HeapAdapter {
+  private:
+    MinHeap<Payload, noTiebreak<Payload, long long>, Arity, Addressable> heap;
+    std::vector<int> handles;
+
+    // A plain heap has no update to call, and is never asked to
+    void update(int id, long long key, std::true_type) {  this->heap.update(this->handles[id], key);  }
+    void update(int, long long, std::false_type) { }
+  public:
+    HeapAdapter(int n) : handles(n, -1) { }
+    void push(long long key, int id, const Payload& p) {  this->handles[id] = this->heap.push(p, key);  }
+    long long pop() {
+      Payload out;
+      return this->heap.popInto(out);
+    }
+    void increase(int id, long long key, const Payload&) {
+      this->update(id, key, std::integral_constant<bool, Addressable>());
+    }
+    void track(int) { }
+    bool isEmpty() {  return this->heap.isEmpty();  }
+};
+
+template<typename Payload>
+class StdAdapter {
+  private:
+    struct Entry {
+      long long key;
+      int id;
+      Payload payload;
+    };
+    struct Later {
+      bool operator()(const Entry& a, const Entry& b) const {  return a.key > b.key;  }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, Later> queue;
+    // Current key of every element for telling stale entries apart, only
+    // kept up once increase has been used
+    std::vector<long long> current;
+  public:
+    StdAdapter(int) { }
+    void push(long long key, int id, const Payload& p) {
+      this->queue.push(Entry{key, id, p});
+      if (!this->current.empty()) {  this->current[id] = key;  }
+    }
+    long long pop() {
+      while (true) {
+        long long key = this->queue.top().key;
+        int id = this->queue.top().id;
+        this->queue.pop();
+        if (this->current.empty() || this->current[id] == key) {  return key;  }
+      }
+    }
+    void increase(int id, long long key, const Payload& p) {
+      this->queue.push(Entry{key, id, p});
+      this->current[id] = key;
+    }
+    void track(int n) {  this->current.assign(n, -1);  }
+    bool isEmpty() {
+      while (!this->current.empty() && !this->queue.empty() &&
+             this->current[this->queue.top().id] != this->queue.top().key) {
+        this->queue.pop();
+      }
+      return this->queue.empty();
+    }
+};
+
+/* runOnce:
+ * Runs a workload on a fresh queue and returns the nanoseconds the timed
+ * part took. Filling the queue for pop, mixed and inckey isn't timed.
+ */
+template<typename Adapter, typename Payload>
+double runOnce(WORKLOAD workload, const Inputs& in, const std::vector<Payload>& payloads) {
+  int n = in.keys.size();
+  Adapter q(n);
+  long long total = 0;
+  std::vector<long long> keys;
+  if (workload == WORK_INCKEY) {
+    q.track(n);
+    keys = in.keys;
+  }
+  if (workload != WORK_PUSH) {
+    for (int i = 0; i < n; i++) {  q.push(in.keys[i], i, payloads[i]);  }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  switch (workload) {
+    case WORK_PUSH:
+      for (int i = 0; i < n; i++) {  q.push(in.keys[i], i, payloads[i]);  }
+      break;
+    case WORK_POP:
+      for (int i = 0; i < n; i++) {  total += q.pop();  }
+      break;
+    case WORK_MIXED:
+      for (int i = 0; i < n; i++) {
+        long long key = q.pop();
+        total += key;
+        q.push(key + in.steps[i], in.targets[i], payloads[in.targets[i]]);
+      }
+      break;
+    case WORK_INCKEY:
+      for (int i = 0; i < n; i++) {
+        int id = in.targets[i];
+        keys[id] += in.steps[i];
+        q.increase(id, keys[id], payloads[id]);
+      }
+      while (!q.isEmpty()) {  total += q.pop();  }
+      break;
+  }
+  auto end = std::chrono::steady_clock::now();
+  sink = total;
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+template<typename Payload>
+double runQueue(QUEUE_KIND queue, WORKLOAD workload, const Inputs& in, const std::vector<Payload>& payloads) {
+  bool handles = workload == WORK_INCKEY;
+  switch (queue) {
+    case QUEUE_HEAP:
+      return handles ? runOnce<HeapAdapter<Payload, 2, true>>(workload, in, payloads)
+                     : runOnce<HeapAdapter<Payload, 2, false>>(workload, in, payloads);
+    case QUEUE_DARY4:
+      return handles ? runOnce<HeapAdapter<Payload, 4, true>>(workload, in, payloads)
+                     : runOnce<HeapAdapter<Payload, 4, false>>(workload, in, payloads);
+    default:
+      return runOnce<StdAdapter<Payload>>(workload, in, payloads);
+  }
+}
+
+struct Options {
+  std::vector<int> sizes = {1000, 10000, 100000, 1000000};
+  std::vector<int> queues = {QUEUE_HEAP, QUEUE_DARY4, QUEUE_STD};
+  std::vector<int> payloads = {PAYLOAD_INT, PAYLOAD_EVENT, PAYLOAD_STRING};
+  std::vector<int> workloads = {WORK_PUSH, WORK_POP, WORK_MIXED, WORK_INCKEY};
+  int warmup = 1;
+  int repetitions = 5;
+  unsigned long long seed = 130;
+  bool json = false;
+};
+
+// Value at quantile q of the sorted timings, interpolating between runs
+double quantile(const std::vector<double>& sorted, double q) {
+  double at = q * (sorted.size() - 1);
+  size_t below = static_cast<size_t>(at);
+  if (below + 1 >= sorted.size()) {  return sorted.back();  }
+  return sorted[below] + (at - below) * (sorted[below + 1] - sorted[below]);
+}
+
+template<typename Payload>
+void benchPayload(const Options& opt, int payload, int size, const Inputs& in, bool& first) {
+  std::vector<Payload> payloads = makePayloads<Payload>(size);
+  for (int workload : opt.workloads) {
+    for (int queue : opt.queues) {
+      QUEUE_KIND q = static_cast<QUEUE_KIND>(queue);
+      WORKLOAD w = static_cast<WORKLOAD>(workload);
+      for (int i = 0; i < opt.warmup; i++) {  runQueue(q, w, in, payloads);  }
+      std::vector<double> perOp;
+      for (int i = 0; i < opt.repetitions; i++) {
+        perOp.push_back(runQueue(q, w, in, payloads) / size);
+      }
+      std::sort(perOp.begin(), perOp.end());
+
+      double stats[] = {perOp.front(), quantile(perOp, 0.1), quantile(perOp, 0.5),
+                        quantile(perOp, 0.9), perOp.back()};
+      if (opt.json) {
+        std::cout << (first ? "" : ",\n") << "  {\"queue\": \"" << QUEUE_NAMES[queue]
+                  << "\", \"payload\": \"" << PAYLOAD_NAMES[payload]
+                  << "\", \"workload\": \"" << WORKLOAD_NAMES[workload]
+                  << "\", \"size\": " << size << ", \"repetitions\": " << opt.repetitions
+                  << ", \"min_ns\": " << stats[0] << ", \"p10_ns\": " << stats[1]
+                  << ", \"median_ns\": " << stats[2] << ", \"p90_ns\": " << stats[3]
+                  << ", \"max_ns\": " << stats[4] << "}";
+      } else {
+        std::cout << QUEUE_NAMES[queue] << "," << PAYLOAD_NAMES[payload] << ","
+                  << WORKLOAD_NAMES[workload] << "," << size << "," << opt.repetitions;
+        for (double s : stats) {  std::cout << "," << s;  }
+        std::cout << std::endl;
+      }
+      first = false;
+    }
+  }
+}
+
+// Parses a comma separated list of names into their indices in names
+bool parseNames(const char *text, const char **names, int count, std::vector<int>& out) {
+  out.clear();
+  std::string list(text);
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos) {  end = list.size();  }
+    std::string name = list.substr(start, end - start);
+    int found = -1;
+    for (int i = 0; i < count; i++) {
+      if (name == names[i]) {  found = i;  }
+    }
+    if (found < 0) {  return false;  }
+    out.push_back(found);
+    start = end + 1;
+  }
+  return !out.empty();
+}
+
+// Sizes may be written like 1e6
+bool parseSizes(const char *text, std::vector<int>& out) {
+  out.clear();
+  while (*text != '\0') {
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || value < 1 || value > 2e9) {  return false;  }
+    out.push_back(static_cast<int>(value));
+    text = end;
+    if (*text == ',') {  text++;  }
+    else if (*text != '\0') {  return false;  }
+  }
+  return !out.empty();
+}
+
+void usage() {
+  std::cout << "Usage: bench [--sizes=1e3,1e4,1e5,1e6] [--queues=heap,dary4,std]" << std::endl
+            << "             [--payloads=int,event,string] [--workloads=push,pop,mixed,inckey]" << std::endl
+            << "             [--warmup=1] [--repetitions=5] [--seed=<s>] [--format=csv|json]" << std::endl;
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    bool ok = true;
+    if (strncmp(argv[i], "--sizes=", 8) == 0) {
+      ok = parseSizes(argv[i] + 8, opt.sizes);
+    } else if (strncmp(argv[i], "--queues=", 9) == 0) {
+      ok = parseNames(argv[i] + 9, QUEUE_NAMES, 3, opt.queues);
+    } else if (strncmp(argv[i], "--payloads=", 11) == 0) {
+      ok = parseNames(argv[i] + 11, PAYLOAD_NAMES, 3, opt.payloads);
+    } else if (strncmp(argv[i], "--workloads=", 12) == 0) {
+      ok = parseNames(argv[i] + 12, WORKLOAD_NAMES, 4, opt.workloads);
+    } else if (strncmp(argv[i], "--warmup=", 9) == 0) {
+      opt.warmup = atoi(argv[i] + 9);
+      ok = opt.warmup >= 0;
+    } else if (strncmp(argv[i], "--repetitions=", 14) == 0) {
+      opt.repetitions = atoi(argv[i] + 14);
+      ok = opt.repetitions >= 1;
+    } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+      opt.seed = strtoull(argv[i] + 7, nullptr, 10);
+    } else if (strcmp(argv[i], "--format=json") == 0) {
+      opt.json = true;
+    } else if (strcmp(argv[i], "--format=csv") == 0) {
+      opt.json = false;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "Bad argument: " << argv[i] << std::endl;
+      usage();
+    }
+  }
+
+  if (opt.json) {
+    std::cout << "{\"seed\": " << opt.seed << ", \"unit\": \"ns_per_op\", \"results\": [" << std::endl;
+  } else {
+    std::cout << "queue,payload,workload,size,repetitions,min_ns,p10_ns,median_ns,p90_ns,max_ns" << std::endl;
+  }
+  bool first = true;
+  for (int size : opt.sizes) {
+    Inputs in = makeInputs(size, opt.seed);
+    for (int payload : opt.payloads) {
+      switch (payload) {
+        case PAYLOAD_INT:
+          benchPayload<int>(opt, payload, size, in, first);
+          break;
+        case PAYLOAD_EVENT:
+          benchPayload<Event>(opt, payload, size, in, first);
+          break;
+        default:
+          benchPayload<std::string>(opt, payload, size, in, first);
+          break;
+      }
+    }
+  }
+  if (opt.json) {
+    std::cout << std::endl << "]}" << std::endl;
+  }
+}
@@ -0,0 +1,214 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "heap.hpp"
+
+// Fewest buckets the calendar shrinks down to, and how many of the earliest
+// entries are looked at when estimating the day width
+const int CALENDAR_MIN_BUCKETS = 2;
+const int CALENDAR_WIDTH_SAMPLE = 25;
+
+/*
+ * Calendar queue (R. Brown, 1988). Time is cut into "days" of a fixed width
+ * and day d lives in bucket d mod numBuckets, like the days of a year on a
+ * desk calendar. Popping walks forward one day at a time from the current
+ * day, so when the width matches the spacing of the pending events both
+ * push and pop take amortized constant time instead of the heap's log n.
+ *
+ * The number of buckets doubles or halves as the queue grows or shrinks and
+ * the day width is re-estimated from the spacing of the earliest events on
+ * every such resize, so the calendar follows a moving window of timestamps.
+ *
+ * Has the same interface and ordering as PriorityQueue: lowest priority
+ * first, with ties settled by the tiebreaker.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie>
+class CalendarQueue {
+  private:
+    typedef PriorityContainer<Contents> Entry;
+    typedef MinOrder<Contents, long long, onTie> Order;
+
+    // Each bucket is a small binary heap with its earliest entry at the 
+    // front. Integer timestamps often tie, and a day can end up holding 
+    // many entries that share one time, so a sorted list would not do
+    std::vector<std::vector<Entry>> buckets;
+    long long width;
+    long long currentDay;
+    int occupied;
+
+    static bool before(Entry& e1, Entry& e2) {
+      return Order::moreTop(e1.priority, e1.content, e2.priority, e2.content);
+    }
+    static bool after(Entry& e1, Entry& e2) {  return before(e2, e1);  }
+    long long dayOf(long long priority) {
+      long long day = priority / this->width;
+      return (priority < 0 && day * this->width != priority) ? day - 1 : day;
+    }
+    int bucketOf(long long day) {
+      long long index = day % static_cast<long long>(this->buckets.size());
+      return static_cast<int>(index < 0 ? index + this->buckets.size() : index);
+    }
+
+    void insert(Entry&& e);
+    int findTop();
+    void removeTop(int index);
+    void resize(int numBuckets);
+  public:
+    CalendarQueue() : buckets(CALENDAR_MIN_BUCKETS), width(1), currentDay(0), occupied(0) { }
+    CalendarQueue(int size) : CalendarQueue() {  (void)size;  }
+
+    void push(Contents& c, long long priority) {  this->insert(Entry(c, priority));  }
+    void push(Contents&& c, long long priority) {  this->insert(Entry(std::move(c), priority));  }
+    template<typename... Args>
+    void emplace(long long priority, Args&&... args) {
+      this->insert(Entry(Contents(std::forward<Args>(args)...), priority));
+    }
+
+    PriorityContainer<Contents> pop();
+    Contents popContent() {  return this->pop().content;  }
+    long long popInto(Contents& out);
+    Contents& top() {  return this->buckets[this->findTop()].front().content;  }
+    long long topPriority() {  return this->buckets[this->findTop()].front().priority;  }
+
+    bool isEmpty() {  return this->occupied == 0;  }
+    int getSize() {  return this->occupied;  }
+
+    // Empties the calendar but keeps the buckets and the width around
+    void clear() {
+      for (auto& bucket : this->buckets) {  bucket.clear();  }
+      this->occupied = 0;
+      this->currentDay = 0;
+    }
+};
+
+
+/* insert:
+ * Drops the entry into the bucket of its day.
+ * An entry earlier than the current day rewinds the calendar to it. Grows
+ * the calendar once there are more than two entries per bucket.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie>
+void CalendarQueue<Contents, onTie>::insert(Entry&& e) {
+  long long day = this->dayOf(e.priority);
+  if (this->occupied == 0 || day < this->currentDay) {
+    this->currentDay = day;
+  }
+  std::vector<Entry>& bucket = this->buckets[this->bucketOf(day)];
+  bucket.push_back(std::move(e));
+  std::push_heap(bucket.begin(), bucket.end(), after);
+  this->occupied++;
+
+  if (this->occupied > 2 * static_cast<int>(this->buckets.size())) {
+    this->resize(2 * this->buckets.size());
+  }
+}
+
+/* findTop:
+ * Returns the bucket holding the earliest entry. Walks forward a day at
+ * a time from the current day looking for a bucket whose earliest entry
+ * falls on that very day. If a whole year goes by without one, the events
+ * are sparse compared to the width, so it jumps straight to the earliest
+ * entry among all the buckets instead.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie>
+int CalendarQueue<Contents, onTie>::findTop() {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  int numBuckets = this->buckets.size();
+  for (int i = 0; i < numBuckets; i++) {
+    int index = this->bucketOf(this->currentDay);
+    std::vector<Entry>& bucket = this->buckets[index];
+    if (!bucket.empty() && this->dayOf(bucket.front().priority) == this->currentDay) {
+      return index;
+    }
+    this->currentDay++;
+  }
+
+  int best = -1;
+  for (int i = 0; i < numBuckets; i++) {
+    if (!this->buckets[i].empty() &&
+        (best == -1 || before(this->buckets[i].front(), this->buckets[best].front()))) {
+      best = i;
+    }
+  }
+  this->currentDay = this->dayOf(this->buckets[best].front().priority);
+  return best;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+PriorityContainer<Contents> CalendarQueue<Contents, onTie>::pop() {
+  int index = this->findTop();
+  Entry toReturn = std::move(this->buckets[index].front());
+  this->removeTop(index);
+  return toReturn;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+long long CalendarQueue<Contents, onTie>::popInto(Contents& out) {
+  int index = this->findTop();
+  long long priority = this->buckets[index].front().priority;
+  out = std::move(this->buckets[index].front().content);
+  this->removeTop(index);
+  return priority;
+}
+
+// Drops the (already moved out) earliest entry of a bucket and shrinks 
+// the calendar once there are fewer than half an entry per bucket
+template<typename Contents, Tiebreaker<Contents> onTie>
+void CalendarQueue<Contents, onTie>::removeTop(int index) {
+  std::vector<Entry>& bucket = this->buckets[index];
+  std::pop_heap(bucket.begin(), bucket.end(), after);
+  bucket.pop_back();
+  this->occupied--;
+  int numBuckets = this->buckets.size();
+  if (this->occupied < numBuckets / 2 && numBuckets > CALENDAR_MIN_BUCKETS) {
+    this->resize(numBuckets / 2);
+  }
+}
+
+/* resize:
+ * Rebuilds the calendar with a new number of buckets. The new day width
+ * is three times the average gap between the earliest few entries,
+ * ignoring gaps more than twice the plain average so that a single far
+ * off event does not blow the width up. This is Brown's estimate and puts
+ * a handful of entries in each day around the current time.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie>
+void CalendarQueue<Contents, onTie>::resize(int numBuckets) {
+  std::vector<Entry> entries;
+  entries.reserve(this->occupied);
+  for (auto& bucket : this->buckets) {
+    for (auto& e : bucket) {
+      entries.push_back(std::move(e));
+    }
+  }
+
+  int sample = std::min(static_cast<int>(entries.size()), CALENDAR_WIDTH_SAMPLE);
+  if (sample > 1) {
+    auto byPriority = [](const Entry& e1, const Entry& e2) {  return e1.priority < e2.priority;  };
+    std::nth_element(entries.begin(), entries.begin() + (sample - 1), entries.end(), byPriority);
+    std::sort(entries.begin(), entries.begin() + sample, byPriority);
+    long long span = entries[sample - 1].priority - entries[0].priority;
+    double average = static_cast<double>(span) / (sample - 1);
+    long long total = 0;
+    int counted = 0;
+    for (int i = 1; i < sample; i++) {
+      long long gap = entries[i].priority - entries[i - 1].priority;
+      if (gap <= 2 * average) {
+        total += gap;
+        counted++;
+      }
+    }
+    long long newWidth = (counted > 0) ? 3 * total / counted : 0;
+    this->width = (newWidth > 0) ? newWidth : 1;
+  }
+
+  this->buckets.assign(numBuckets, std::vector<Entry>());
+  this->occupied = 0;
+  for (auto& e : entries) {
+    this->insert(std::move(e));
+  }
+}
+
+#endif
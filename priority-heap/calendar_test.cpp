@@ -0,0 +1,46 @@
+#include "calendar.hpp"
+#include "pqueue.hpp"
+#include <iostream>
+#include <random>
+
+bool tiebreaker(int& x1, long long, int& x2, long long) {
+  return x1 < x2;
+}
+
+// Runs the classic "hold" workload (pop the earliest event, schedule a new 
+// one a random distance after it) on a calendar queue and a heap side by 
+// side and checks that both hand out the same sequence of events
+bool checkHold(int size, int holds, int spread, std::mt19937& mt) {
+  CalendarQueue<int, tiebreaker> calendar;
+  PriorityQueue<int, tiebreaker> heap;
+  std::uniform_int_distribution<int> increment(0, spread);
+  int id = 0;
+  for (int i = 0; i < size; i++, id++) {
+    long long time = increment(mt);
+    calendar.push(id, time);
+    heap.push(id, time);
+  }
+  bool same = true;
+  for (int i = 0; i < holds; i++, id++) {
+    auto c = calendar.pop();
+    auto h = heap.pop();
+    same = same && (c.priority == h.priority) && (c.content == h.content);
+    long long time = c.priority + increment(mt);
+    calendar.push(id, time);
+    heap.push(id, time);
+  }
+  while (!heap.isEmpty()) {
+    auto c = calendar.pop();
+    auto h = heap.pop();
+    same = same && (c.priority == h.priority) && (c.content == h.content);
+  }
+  return same && calendar.isEmpty();
+}
+
+int main() {
+  std::mt19937 mt(130);
+  std::cout << "HOLD SMALL: " << (checkHold(10, 10000, 100, mt) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+  std::cout << "HOLD LARGE: " << (checkHold(10000, 100000, 1000, mt) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+  std::cout << "HOLD TIES: " << (checkHold(1000, 10000, 3, mt) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+  std::cout << "HOLD SPARSE: " << (checkHold(100, 10000, 1000000, mt) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+}
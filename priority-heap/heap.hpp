@@ -1,115 +1,293 @@
 #ifndef HEAP_H
 #define HEAP_H
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "instrument.hpp"
 
 /*
  * Container for the heap. Has a field for the content and a tag to support 
  * the priority within the heap. Has overloaded comparison operators to make 
  * writing tiebreaker functions more convenient
  */
-template<typename Content>
+template<typename Content, typename Key = long long>
 class PriorityContainer {
   public: 
     PriorityContainer() : priority(0) { }
-    PriorityContainer(Content content, long long priority) : content(content), priority(priority) { }
+    PriorityContainer(Content content, Key priority) : content(std::move(content)), priority(priority) { }
     Content content;
-    long long priority;
+    Key priority;
     
-    bool operator==(PriorityContainer<Content> const& rhs) {  return this->priority == rhs.priority;  }
-    bool operator<(PriorityContainer<Content> const& rhs) {  return this->priority < rhs.priority;  }
-    bool operator>(PriorityContainer<Content> const& rhs) {  return this->priority > rhs.priority;  }
+    bool operator==(PriorityContainer const& rhs) {  return this->priority == rhs.priority;  }
+    bool operator<(PriorityContainer const& rhs) {  return this->priority < rhs.priority;  }
+    bool operator>(PriorityContainer const& rhs) {  return this->priority > rhs.priority;  }
 
-    bool operator!=(PriorityContainer<Content> const& rhs) {  return !(*this == rhs);  }
-    bool operator<=(PriorityContainer<Content> const& rhs) {  return (*this == rhs) || (*this < rhs);  }
-    bool operator>=(PriorityContainer<Content> const& rhs) {  return (*this == rhs) || (*this > rhs);  }
+    bool operator!=(PriorityContainer const& rhs) {  return !(*this == rhs);  }
+    bool operator<=(PriorityContainer const& rhs) {  return (*this == rhs) || (*this < rhs);  }
+    bool operator>=(PriorityContainer const& rhs) {  return (*this == rhs) || (*this > rhs);  }
 };
 
 // Since not much info is needed from the error messages, it is easiest 
 // to just return an error code
 enum HeapErrorCodes {OVERRIDE, NO_ELEMENT, NO_CHILD}; 
 
+// Size of the cache line we try to fit a group of siblings into
+const int HEAP_CACHE_LINE = 64;
+
+// Smallest capacity the heap will grow to or shrink down to
+const int HEAP_MIN_CAPACITY = 16;
+
+// Create an alias for the type of Tiebreaker function pointers
+template<typename Content, typename Key = long long>
+using Tiebreaker = bool (*)(Content& c1, Key p1, Content& c2, Key p2);
+
+// Tiebreaker for when the order of equal priorities does not matter. Lets 
+// the sifting loops skip the payloads entirely
+template<typename Content, typename Key = long long>
+bool noTiebreak(Content&, Key, Content&, Key) {  return false;  }
+
+/*
+ * Ordering policies. The heap is templated over one of these and calls its
+ * static moreTop directly, so the comparison (and the tiebreaker, which is 
+ * a compile time constant) gets inlined into the sifting loops instead of 
+ * going through a virtual call and a function pointer. Any type with a 
+ * matching static moreTop can be used to get a custom ordering. keyMoreTop
+ * compares bare priorities and is only needed by popUntil.
+ */
+template<typename Content, typename Key, Tiebreaker<Content, Key> onTie>
+struct MinOrder {
+  static bool moreTop(Key p1, Content& c1, Key p2, Content& c2) {
+    if (p1 == p2) {
+      return onTie(c1, p1, c2, p2);
+    } else {
+      return p1 < p2;
+    }
+  }
+  static bool keyMoreTop(Key p1, Key p2) {  return p1 < p2;  }
+};
+
+template<typename Content, typename Key, Tiebreaker<Content, Key> onTie>
+struct MaxOrder {
+  static bool moreTop(Key p1, Content& c1, Key p2, Content& c2) {
+    if (p1 == p2) {
+      return onTie(c1, p1, c2, p2);
+    } else {
+      return p1 > p2;
+    }
+  }
+  static bool keyMoreTop(Key p1, Key p2) {  return p1 > p2;  }
+};
+
 
 /* 
- * The main heap object. Contains a dynamically allocated array that holds
- * all of the PriorityContainer objects. Keeps track of the elements in the 
- * array by a count of the occupied cells and the total number of cells, 
- * allowing it to automatically resize itself when necessary. 
+ * The main heap object. An implicit d-ary heap (Arity children per node) 
+ * kept in two parallel dynamically allocated arrays: one holding only the 
+ * priorities and one holding the payloads. The sifting loops only stream the
+ * priority array and only look at a payload when two priorities tie, so large
+ * payloads no longer get dragged through the cache on every comparison. 
  *
- * NOTE: this class should be subclassed to be used. The comparison function
- * moreTop is meant to be overriden.
+ * The priority array is offset so that index 1 starts on a cache line 
+ * boundary. Since the children of node i live at Arity * i + 1 through 
+ * Arity * i + Arity, every group of siblings shares a single cache line 
+ * as long as Arity * sizeof(Key) fits in one.
+ *
+ * Keeps track of the elements in the arrays by a count of the occupied cells
+ * and the total number of cells, allowing it to automatically resize itself 
+ * when necessary. All of the storage comes from Alloc (rebound for the 
+ * priorities and the position map) and payloads are only constructed in the
+ * cells that are actually occupied, so reserving room is cheap no matter 
+ * what the payload is. The capacity grows by a configurable factor and can
+ * optionally be given back as the heap drains.
+ *
+ * The ordering is given by the Order policy (see MinOrder and MaxOrder) and
+ * the priorities can be any type Order knows how to compare.
+ *
+ * An Addressable heap additionally hands out a stable handle from push and 
+ * keeps a position map (handle -> index) up to date as elements move, so 
+ * the priority of an element can be updated, or the element erased, without
+ * knowing where it currently sits. Handles of popped or erased elements get
+ * recycled. A heap that is not Addressable carries none of this bookkeeping.
  */
-template<typename NodeContents>
+template<typename NodeContents, typename Order, int Arity = 2, typename Key = long long, 
+         bool Addressable = false, typename Alloc = std::allocator<NodeContents>>
 class Heap {
+  static_assert(Arity >= 2, "A heap needs at least two children per node");
   private:
+    typedef std::allocator_traits<Alloc> PayloadTraits;
+    typedef typename PayloadTraits::template rebind_alloc<char> BlockAlloc;
+    typedef typename PayloadTraits::template rebind_alloc<int> IndexAlloc;
+
+    Alloc alloc;
+    double growthFactor;
+    bool shrinkOnDrain;
+
     int size;
     int occupied;
-    PriorityContainer<NodeContents> *contents;
+    char *priorityBlock;
+    Key *priorities;
+    NodeContents *payloads;
+
+    // Position map, only allocated when Addressable. Free handles are 
+    // chained through their own entries in handlePositions
+    int *slotHandles;
+    int *handlePositions;
+    int handleCount;
+    int handleCapacity;
+    int freeHandle;
+
+#ifdef PQ_INSTRUMENT
+    HeapCounters counters;
+    static std::string instrumentType() {
+      return "heap<arity=" + std::to_string(Arity) + ", key=" + std::to_string(sizeof(Key)) + 
+             "B, payload=" + std::to_string(sizeof(NodeContents)) + "B" + (Addressable ? ", addressable>" : ">");
+    }
+#endif
 
     int getLastIndex() {  return this->occupied - 1;  }
     int getOpenIndex() {  return this->occupied;  }
 
-    void place(PriorityContainer<NodeContents> x, int index);
-
-    PriorityContainer<NodeContents> grab(int index);
-
-    virtual bool moreTop(PriorityContainer<NodeContents>& x1, 
-                         PriorityContainer<NodeContents>& x2) {  return true;  }
+    void allocate(int size);
+    void release(char *block, NodeContents *payloads, int *handles, int size);
+    void resize(int newSize);
+    void grow(int needed);
+    void shrinkIfDrained();
+    void destroy(int index) {  PayloadTraits::destroy(this->alloc, this->payloads + index);  }
+    static std::size_t blockBytes(int size) {  return sizeof(Key) * size + 2 * HEAP_CACHE_LINE;  }
+
+    int acquireHandle();
+    void releaseHandle(int handle);
+    int handleAt(int index) {  return Addressable ? this->slotHandles[index] : -1;  }
+
+    void moveNode(int from, int to);
+    void settle(int index, Key priority, NodeContents& content, int handle);
+
+    // Every comparison of two elements goes through here
+    bool moreTop(Key p1, NodeContents& c1, Key p2, NodeContents& c2) {
+      PQ_COUNT(comparisons);
+      return Order::moreTop(p1, c1, p2, c2);
+    }
     bool compare(int index1, int index2) {
-      auto node1 = this->grab(index1);
-      auto node2 = this->grab(index2);
-      return this->moreTop(node1, node2);
+      return this->moreTop(this->priorities[index1], this->payloads[index1],
+                           this->priorities[index2], this->payloads[index2]);
     }
-    int returnTopper(int index1, int index2);
+    int returnTopper(int index);
 
     void percolateDown(int index);
-    void percolateUp(int index);
-
-    int getRightChildIndex(int index);
-    int getLeftChildIndex(int index);
-    int getChildIndex(int index, bool isLeft);
-    PriorityContainer<NodeContents> getRightChild(int index);
-    PriorityContainer<NodeContents> getLeftChild(int index);
-    PriorityContainer<NodeContents> getChild(int index, bool isLeft);
+    int percolateUp(int index);
+    void heapify();
+    void removeTop();
+    template<typename Iterator>
+    void append(Iterator first, Iterator last, int *handlesOut);
+
+    // Batch removal. topOrder walks the frontier of the heap with a small
+    // heap of indices to find the count topmost elements in order without
+    // touching anything, and takeAll moves a set of them out and rebuilds
+    // what is left in one go. That beats sifting after every pop once a
+    // batch is more than about one element per level of the heap, until
+    // it gets past a quarter of the heap and the frontier gets too big
+    int levelsFor(int count);
+    bool worthRebuilding(int taken) {  
+      return static_cast<long long>(taken) * this->levelsFor(this->occupied) > this->occupied &&
+             taken <= this->occupied / 4;
+    }
+    void topOrder(int count, std::vector<int>& order);
+    int countUpTo(Key priority);
+    template<typename OutputIt>
+    void takeAll(const std::vector<int>& order, OutputIt out);
+
+    int getFirstChildIndex(int index) {  return Arity * index + 1;  }
     int getParentIndex(int index);
-    PriorityContainer<NodeContents> getParent(int index);
-    PriorityContainer<NodeContents> getNode(int index);
     bool hasNode(int index);
   public:
     Heap();
-    Heap(int initialSize);
-    Heap(Heap& h);
-    Heap(Heap<NodeContents>&& other);
-    Heap<NodeContents> operator=(Heap<NodeContents>& h);
+    Heap(int initialSize, const Alloc& alloc = Alloc());
+    explicit Heap(const Alloc& alloc);
+    template<typename Iterator>
+    Heap(Iterator first, Iterator last, int *handlesOut = nullptr, const Alloc& alloc = Alloc());
+    Heap(const std::vector<PriorityContainer<NodeContents, Key>>& elements, const Alloc& alloc = Alloc()) 
+      : Heap(elements.begin(), elements.end(), nullptr, alloc) { }
+    Heap(const Heap& h);
+    Heap(Heap&& other);
+    Heap& operator=(const Heap& h);
+    Heap& operator=(Heap&& h);
     ~Heap();
 
-    void push(PriorityContainer<NodeContents> x);
-    void push(NodeContents x, int priority) {
-      this->push(PriorityContainer<NodeContents>(x, priority));
+    // All of these return the handle of the new element, or -1 if the heap 
+    // is not Addressable. Payloads are only ever moved once inside the heap, 
+    // so passing an rvalue (or using emplace) never copies the payload
+    int push(PriorityContainer<NodeContents, Key> x);
+    int push(NodeContents x, Key priority) {
+      return this->emplace(priority, std::move(x));
     }
-    PriorityContainer<NodeContents> pop();
+    template<typename... Args>
+    int emplace(Key priority, Args&&... args);
+
+    PriorityContainer<NodeContents, Key> pop();
+
+    // Moves the top payload into out and returns its priority. Together 
+    // with top, this lets the caller drain the heap without copying payloads
+    Key popInto(NodeContents& out);
+
+    // Batch pops. popK takes the k topmost elements (or all of them if
+    // there are fewer) and popUntil every element whose priority is not 
+    // past the given one, writing them in order to out, which can be a 
+    // pointer into a big enough buffer or an inserter. Both return how 
+    // many they took. Taking a big share of the heap rebuilds it once 
+    // instead of sifting after every element. peekTopK copies out the k
+    // topmost elements in order and leaves the heap as it is
+    template<typename OutputIt>
+    int popK(int k, OutputIt out);
+    template<typename OutputIt>
+    int popUntil(Key priority, OutputIt out);
+    template<typename OutputIt>
+    int peekTopK(int k, OutputIt out);
+    NodeContents& top();
+    Key topPriority();
+
+    // Adds a whole range of PriorityContainers at once. If handlesOut is 
+    // given it receives the handle of every element, in order
+    template<typename Iterator>
+    void pushBatch(Iterator first, Iterator last, int *handlesOut = nullptr);
 
     // Since I make no assumptions about the comparison function 
     // except that it gives a legitimate location in the heap for
     // the object, it is necessary to try both percolateUp'ing and
     // percolateDown'ing
-    void incKey(int index, int val) {
-      this->contents[index].priority += val;
-      this->percolateUp(index);
-      this->percolateDown(index);
+    void incKey(int index, Key val) {
+      this->priorities[index] += val;
+      this->percolateDown(this->percolateUp(index));
     }
     
-    void decKey(int index, int val) {
-      this->contents[index].priority -= val;
-      this->percolateUp(index);
-      this->percolateDown(index);
+    void decKey(int index, Key val) {
+      this->priorities[index] -= val;
+      this->percolateDown(this->percolateUp(index));
     }
 
+    // Handle based access, only available on Addressable heaps
+    bool contains(int handle);
+    Key getPriority(int handle);
+    void update(int handle, Key newPriority);
+    void erase(int handle);
+
+    // Storage management. clear keeps the capacity for reuse, reserve only
+    // ever grows it and shrinkToFit drops it down to the number of elements
+    void clear();
+    void reserve(int capacity) {  if (capacity > this->size) {  this->resize(capacity);  }  }
+    void shrinkToFit() {  if (this->size > this->occupied) {  this->resize(this->occupied);  }  }
+    void setGrowthFactor(double factor) {  this->growthFactor = (factor > 1.0) ? factor : 1.0;  }
+    void setShrinkOnDrain(bool shrink) {  this->shrinkOnDrain = shrink;  }
+    int getCapacity() {  return this->size;  }
+    int getSize() {  return this->occupied;  }
+#ifdef PQ_INSTRUMENT
+    const HeapCounters& getCounters() const {  return this->counters;  }
+#endif
+
     bool isEmpty() {  return this->occupied == 0;  }
 };
 
-// Create an alias for the type of Tiebreaker function pointers
-template<typename Content>
-using Tiebreaker = bool (*)(Content& c1, int p1, Content& c2, int p2);
-
 /*
  * The actual classes that are mean to be used. Min and Max heap are both
  * templated on a tiebreaker function, which compares two objects in the 
@@ -117,214 +295,665 @@ using Tiebreaker = bool (*)(Content& c1, int p1, Content& c2, int p2);
  * function because the changing of this function utterly changes the ordering
  * of the heap and therefore the type of the heap itself
  */
-template<typename NodeContents, Tiebreaker<NodeContents> onTie>
-class MinHeap : public Heap<NodeContents> {
-  private:
-    bool moreTop(PriorityContainer<NodeContents>& x1, 
-                 PriorityContainer<NodeContents>& x2) { 
-      if (x1 == x2) {
-        return onTie(x1.content, x1.priority, x2.content, x2.priority);
-      } else {
-        return x1 < x2;
-      }
-    }
+template<typename NodeContents, Tiebreaker<NodeContents> onTie, int Arity = 2, 
+         bool Addressable = false, typename Alloc = std::allocator<NodeContents>>
+class MinHeap : public Heap<NodeContents, MinOrder<NodeContents, long long, onTie>, Arity, long long, Addressable, Alloc> {
+  public:
+    using Heap<NodeContents, MinOrder<NodeContents, long long, onTie>, Arity, long long, Addressable, Alloc>::Heap;
 };
 
-template<typename NodeContents, Tiebreaker<NodeContents> onTie>
-class MaxHeap : public Heap<NodeContents> {
-  private:
-    bool moreTop(PriorityContainer<NodeContents>& x1, 
-                 PriorityContainer<NodeContents>& x2) { 
-      if (x1 == x2) {
-        return onTie(x1.content, x1.priority, x2.content, x2.priority);
-      } else {
-        return x1 > x2;
-      }
-    }
+template<typename NodeContents, Tiebreaker<NodeContents> onTie, int Arity = 2, 
+         bool Addressable = false, typename Alloc = std::allocator<NodeContents>>
+class MaxHeap : public Heap<NodeContents, MaxOrder<NodeContents, long long, onTie>, Arity, long long, Addressable, Alloc> {
+  public:
+    using Heap<NodeContents, MaxOrder<NodeContents, long long, onTie>, Arity, long long, Addressable, Alloc>::Heap;
 };
 
 // Constructors and Destructors
-template<typename NodeContents>
-Heap<NodeContents>::Heap(int initialSize) {
-  this->contents = new PriorityContainer<NodeContents>[initialSize];
-  this->size = initialSize;
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::Heap(int initialSize, const Alloc& alloc) 
+  : alloc(alloc), growthFactor(2.0), shrinkOnDrain(false), slotHandles(nullptr), 
+    handlePositions(nullptr), handleCount(0), handleCapacity(0), freeHandle(-1) {
+  this->allocate(initialSize);
   this->occupied = 0;
 }
 
-// Guess a good starting size for the user
-template<typename NodeContents>
-Heap<NodeContents>::Heap() : Heap(20) { }
+// Guess a good starting size for the user. Nothing gets constructed in 
+// the cells, so guessing high is cheap
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::Heap() : Heap(20) { }
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::Heap(const Alloc& alloc) : Heap(20, alloc) { }
+
+// Bulk constructor. Builds the heap from a range of PriorityContainers 
+// in linear time by dropping them in as-is and heapifying once
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename Iterator>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::Heap(Iterator first, Iterator last, int *handlesOut, const Alloc& alloc) 
+  : Heap(static_cast<int>(std::distance(first, last)), alloc) {
+  this->append(first, last, handlesOut);
+  this->heapify();
+}
 
 // Copy constructor
-template<typename NodeContents>
-Heap<NodeContents>::Heap(Heap<NodeContents>& rhs) : Heap() {
-  this->contents = new PriorityContainer<NodeContents>[rhs.size];
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::Heap(const Heap& rhs) 
+  : Heap(rhs.size, PayloadTraits::select_on_container_copy_construction(rhs.alloc)) {
+  this->growthFactor = rhs.growthFactor;
+  this->shrinkOnDrain = rhs.shrinkOnDrain;
   for (int i = 0; i < rhs.occupied; i++) {
-    this->contents[i] = rhs.contents[i];
+    this->priorities[i] = rhs.priorities[i];
+    PayloadTraits::construct(this->alloc, this->payloads + i, rhs.payloads[i]);
   }
   this->occupied = rhs.occupied;
-  this->size = rhs.size;
+  if (Addressable) {
+    for (int i = 0; i < rhs.occupied; i++) {
+      this->slotHandles[i] = rhs.slotHandles[i];
+    }
+    IndexAlloc indexAlloc(this->alloc);
+    this->handlePositions = indexAlloc.allocate(rhs.handleCapacity);
+    for (int i = 0; i < rhs.handleCount; i++) {
+      this->handlePositions[i] = rhs.handlePositions[i];
+    }
+    this->handleCount = rhs.handleCount;
+    this->handleCapacity = rhs.handleCapacity;
+    this->freeHandle = rhs.freeHandle;
+  }
+}
+
+// Move constructor. Steals the arrays and leaves the other heap empty
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::Heap(Heap&& rhs) 
+  : alloc(std::move(rhs.alloc)), growthFactor(rhs.growthFactor), shrinkOnDrain(rhs.shrinkOnDrain),
+    size(rhs.size), occupied(rhs.occupied), priorityBlock(rhs.priorityBlock),
+    priorities(rhs.priorities), payloads(rhs.payloads), slotHandles(rhs.slotHandles),
+    handlePositions(rhs.handlePositions), handleCount(rhs.handleCount), 
+    handleCapacity(rhs.handleCapacity), freeHandle(rhs.freeHandle) {
+  rhs.size = rhs.occupied = 0;
+  rhs.priorityBlock = nullptr;
+  rhs.priorities = nullptr;
+  rhs.payloads = nullptr;
+  rhs.slotHandles = rhs.handlePositions = nullptr;
+  rhs.handleCount = rhs.handleCapacity = 0;
+  rhs.freeHandle = -1;
+#ifdef PQ_INSTRUMENT
+  this->counters = rhs.counters;
+  rhs.counters = HeapCounters();
+#endif
 }
 
-// Overloaded assignment operator. While admittedly not the most robust
-// implementation, this program is not intended to function in an environment 
-// in which it is absolutely critical that it performs
-template<typename NodeContents>
-Heap<NodeContents> Heap<NodeContents>::operator=(Heap<NodeContents>& rhs) {
-  delete[] this->contents;
-  new (this) Heap(rhs);
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>& Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::operator=(const Heap& rhs) {
+  if (this != &rhs) {
+    Heap copy(rhs);
+    *this = std::move(copy);
+  }
   return *this;
 }
 
-template<typename NodeContents>
-Heap<NodeContents>::~Heap() {
-  delete[] this->contents;
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>& Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::operator=(Heap&& rhs) {
+  if (this != &rhs) {
+    std::swap(this->alloc, rhs.alloc);
+    std::swap(this->growthFactor, rhs.growthFactor);
+    std::swap(this->shrinkOnDrain, rhs.shrinkOnDrain);
+    std::swap(this->size, rhs.size);
+    std::swap(this->occupied, rhs.occupied);
+    std::swap(this->priorityBlock, rhs.priorityBlock);
+    std::swap(this->priorities, rhs.priorities);
+    std::swap(this->payloads, rhs.payloads);
+    std::swap(this->slotHandles, rhs.slotHandles);
+    std::swap(this->handlePositions, rhs.handlePositions);
+    std::swap(this->handleCount, rhs.handleCount);
+    std::swap(this->handleCapacity, rhs.handleCapacity);
+    std::swap(this->freeHandle, rhs.freeHandle);
+#ifdef PQ_INSTRUMENT
+    std::swap(this->counters, rhs.counters);
+#endif
+  }
+  return *this;
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::~Heap() {
+#ifdef PQ_INSTRUMENT
+  if (this->counters.pushes > 0) {  InstrumentRegistry::get().addHeap(instrumentType(), this->counters);  }
+#endif
+  if (this->payloads == nullptr) {  return;  }
+  for (int i = 0; i < this->occupied; i++) {
+    this->destroy(i);
+  }
+  this->release(this->priorityBlock, this->payloads, this->slotHandles, this->size);
+  if (this->handlePositions != nullptr) {
+    IndexAlloc indexAlloc(this->alloc);
+    indexAlloc.deallocate(this->handlePositions, this->handleCapacity);
+  }
+}
+
+/* allocate:
+ * Gets raw storage for the parallel arrays from the allocator. Nothing is 
+ * constructed here; payloads are built in place as cells become occupied.
+ * The priority block is over-allocated by a cache line so the array can be 
+ * shifted until index 1 sits on a line boundary, which keeps every sibling 
+ * group inside one line.
+ */
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::allocate(int size) {
+  BlockAlloc blockAlloc(this->alloc);
+  this->size = size;
+  this->priorityBlock = blockAlloc.allocate(blockBytes(size));
+  std::uintptr_t firstChild = reinterpret_cast<std::uintptr_t>(this->priorityBlock) + sizeof(Key);
+  firstChild = (firstChild + HEAP_CACHE_LINE - 1) & ~static_cast<std::uintptr_t>(HEAP_CACHE_LINE - 1);
+  this->priorities = reinterpret_cast<Key *>(firstChild) - 1;
+  this->payloads = PayloadTraits::allocate(this->alloc, size);
+  if (Addressable) {
+    IndexAlloc indexAlloc(this->alloc);
+    this->slotHandles = indexAlloc.allocate(size);
+  }
+}
+
+// Hands a set of arrays back to the allocator. Any payloads in them 
+// have to be destroyed already
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::release(char *block, NodeContents *payloads, int *handles, int size) {
+  BlockAlloc blockAlloc(this->alloc);
+  blockAlloc.deallocate(block, blockBytes(size));
+  PayloadTraits::deallocate(this->alloc, payloads, size);
+  if (Addressable) {
+    IndexAlloc indexAlloc(this->alloc);
+    indexAlloc.deallocate(handles, size);
+  }
+}
+
+// Reallocates the arrays and moves the occupied cells over
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::resize(int newSize) {
+  PQ_COUNT(resizes);
+  char *oldBlock = this->priorityBlock;
+  Key *oldPriorities = this->priorities;
+  NodeContents *oldPayloads = this->payloads;
+  int *oldHandles = this->slotHandles;
+  int oldSize = this->size;
+  this->allocate(newSize);
+  for (int i = 0; i < this->occupied; i++) {
+    this->priorities[i] = oldPriorities[i];
+    PayloadTraits::construct(this->alloc, this->payloads + i, std::move(oldPayloads[i]));
+    PayloadTraits::destroy(this->alloc, oldPayloads + i);
+  }
+  if (Addressable) {
+    for (int i = 0; i < this->occupied; i++) {
+      this->slotHandles[i] = oldHandles[i];
+    }
+  }
+  this->release(oldBlock, oldPayloads, oldHandles, oldSize);
+}
+
+// Destroys every element but keeps the storage around for reuse
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::clear() {
+  for (int i = 0; i < this->occupied; i++) {
+    this->destroy(i);
+  }
+  this->occupied = 0;
+  this->handleCount = 0;
+  this->freeHandle = -1;
+}
+
+// Grows the capacity by the growth factor, or to needed if that is more
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::grow(int needed) {
+  int newSize = static_cast<int>(this->size * this->growthFactor);
+  if (newSize <= this->size) {  newSize = this->size + 1;  }
+  if (newSize < HEAP_MIN_CAPACITY) {  newSize = HEAP_MIN_CAPACITY;  }
+  if (newSize < needed) {  newSize = needed;  }
+  this->resize(newSize);
+}
+
+// Halves the capacity once the heap is down to a quarter of it, which 
+// keeps a steady push/pop pattern from thrashing between two sizes
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::shrinkIfDrained() {
+  if (this->shrinkOnDrain && this->size > HEAP_MIN_CAPACITY && this->occupied < this->size / 4) {
+    int newSize = this->size / 2;
+    this->resize(newSize > HEAP_MIN_CAPACITY ? newSize : HEAP_MIN_CAPACITY);
+  }
 }
 
 
 /* push: 
- * Checks the size of the current heap and resizes the dynamic array in 
- * memory, copying the data between the old and new arrays. To make sure we're
+ * Checks the size of the current heap and resizes the dynamic arrays in 
+ * memory, moving the data between the old and new arrays. To make sure we're
  * not constantly performing the relatively expensive operation of resizing the
- * heap, we double the size each time we resize. 
+ * heap, we grow by the growth factor (double by default) each time. 
  * For the actual operation, we simply place the new item in the bottom-most index
  * and then percolate it upwards until it finds its correct position. 
  */
-template<typename NodeContents>
-void Heap<NodeContents>::push(PriorityContainer<NodeContents> x) {
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::push(PriorityContainer<NodeContents, Key> x) {
+  return this->emplace(x.priority, std::move(x.content));
+}
+
+// Builds the payload from args directly in the open cell
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename... Args>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::emplace(Key priority, Args&&... args) {
   if (this->occupied >= this->size) {
-    int newSize = this->occupied * 2;
-    PriorityContainer<NodeContents> *newContents = new PriorityContainer<NodeContents>[newSize];
-    for (int i = 0; i < this->occupied; i++) {
-      newContents[i] = this->contents[i];
-    }
-    delete[] this->contents;
-    this->contents = newContents;
-    this->size = newSize;
+    this->grow(this->occupied + 1);
   }
 
-  this->place(x, this->getOpenIndex());
+  int index = this->getOpenIndex();
+  PayloadTraits::construct(this->alloc, this->payloads + index, std::forward<Args>(args)...);
+  this->priorities[index] = priority;
+  int handle = this->acquireHandle();
+  if (Addressable) {
+    this->slotHandles[index] = handle;
+    this->handlePositions[handle] = index;
+  }
   this->occupied++;
+  PQ_COUNT(pushes);
+  PQ_PEAK(this->occupied);
   this->percolateUp(this->getLastIndex());
+  return handle;
+}
+
+/* pushBatch:
+ * Appends every element to the bottom of the heap with a single resize and 
+ * then restores the heap in whichever way is cheaper. Sifting each new 
+ * element up costs up to log(n) per element, while heapifying the whole 
+ * array (Floyd's method) costs a bounded number of steps per element of the 
+ * heap, so the rebuild wins once the batch is a large enough share of it.
+ * Payloads are copied out of the range, wrap the iterators with 
+ * std::make_move_iterator to move them instead.
+ */
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename Iterator>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::pushBatch(Iterator first, Iterator last, int *handlesOut) {
+  int count = static_cast<int>(std::distance(first, last));
+  int oldOccupied = this->occupied;
+  int newOccupied = oldOccupied + count;
+  if (newOccupied > this->size) {
+    this->grow(newOccupied);
+  }
+  this->append(first, last, handlesOut);
+
+  if (static_cast<long long>(count) * this->levelsFor(newOccupied) > newOccupied) {
+    this->heapify();
+  } else {
+    for (int i = oldOccupied; i < newOccupied; i++) {
+      this->percolateUp(i);
+    }
+  }
 }
 
 /* pop:
- * Gets the node to return, and then addresses the edge case of us having removed
- * the last node in the heap. Grabs the bottom-most element in the heap, places it
- * in the top where we just removed an element, and then percolates it downward. 
+ * Moves the top node out, and then addresses the edge case of us having removed
+ * the last node in the heap. Moves the bottom-most element in the heap into the
+ * top where we just removed an element, and then percolates it downward. 
  * Eventually returns the value we popped off the heap.
  */
-template<typename NodeContents>
-PriorityContainer<NodeContents> Heap<NodeContents>::pop() {
-  PriorityContainer<NodeContents> toReturn = this->grab(0);
-  if (this->getLastIndex() == 0) {
-    this->occupied--;
-    return toReturn;
-  }
-  auto lastNode = this->grab(this->getLastIndex());
-  this->occupied--;
-  this->place(lastNode, 0);
-  this->percolateDown(0);
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+PriorityContainer<NodeContents, Key> Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::pop() {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  PriorityContainer<NodeContents, Key> toReturn(std::move(this->payloads[0]), this->priorities[0]);
+  this->removeTop();
   return toReturn;
 }
+
+// Same as pop, but hands the payload to the caller by moving it into out
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Key Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::popInto(NodeContents& out) {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  Key priority = this->priorities[0];
+  out = std::move(this->payloads[0]);
+  this->removeTop();
+  return priority;
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename OutputIt>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::popK(int k, OutputIt out) {
+  if (k > this->occupied) {  k = this->occupied;  }
+  if (k <= 0) {  return 0;  }
+  if (this->worthRebuilding(k)) {
+    std::vector<int> order;
+    this->topOrder(k, order);
+    this->takeAll(order, out);
+    return k;
+  }
+  for (int i = 0; i < k; i++) {
+    *out++ = PriorityContainer<NodeContents, Key>(std::move(this->payloads[0]), this->priorities[0]);
+    this->removeTop();
+  }
+  return k;
+}
+
+// Ties with priority are taken. What gets taken is always a subtree 
+// hanging off the top, so it can be counted without ordering it
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename OutputIt>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::popUntil(Key priority, OutputIt out) {
+  int count = this->countUpTo(priority);
+  return this->popK(count, out);
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename OutputIt>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::peekTopK(int k, OutputIt out) {
+  std::vector<int> order;
+  this->topOrder(k, order);
+  for (int index : order) {
+    *out++ = PriorityContainer<NodeContents, Key>(this->payloads[index], this->priorities[index]);
+  }
+  return static_cast<int>(order.size());
+}
+
+// Fills the hole left by a top that has already been moved out
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::removeTop() {
+  PQ_COUNT(pops);
+  if (Addressable) {  this->releaseHandle(this->slotHandles[0]);  }
+  int last = this->getLastIndex();
+  this->occupied--;
+  if (last != 0) {
+    this->moveNode(last, 0);
+    this->destroy(last);
+    this->percolateDown(0);
+  } else {
+    this->destroy(0);
+  }
+  this->shrinkIfDrained();
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+NodeContents& Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::top() {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  return this->payloads[0];
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Key Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::topPriority() {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  return this->priorities[0];
+}
+
+
+// Handle based operations. Each one looks the element up through the 
+// position map and then lets the percolation methods restore the heap
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+bool Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::contains(int handle) {
+  static_assert(Addressable, "Handles are only tracked by Addressable heaps");
+  return (handle >= 0) && (handle < this->handleCount) && (this->handlePositions[handle] >= 0);
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+Key Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::getPriority(int handle) {
+  if (!this->contains(handle)) {  throw NO_ELEMENT;  }
+  return this->priorities[this->handlePositions[handle]];
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::update(int handle, Key newPriority) {
+  if (!this->contains(handle)) {  throw NO_ELEMENT;  }
+  int index = this->handlePositions[handle];
+  this->priorities[index] = newPriority;
+  this->percolateDown(this->percolateUp(index));
+}
+
+// Fills the hole with the bottom-most element, which may have to move 
+// either way from there
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::erase(int handle) {
+  if (!this->contains(handle)) {  throw NO_ELEMENT;  }
+  int index = this->handlePositions[handle];
+  this->releaseHandle(handle);
+  int last = this->getLastIndex();
+  this->occupied--;
+  if (index != last) {
+    this->moveNode(last, index);
+    this->destroy(last);
+    this->percolateDown(this->percolateUp(index));
+  } else {
+    this->destroy(last);
+  }
+  this->shrinkIfDrained();
+}
+
+// Handle bookkeeping. Free handles form a linked list through the 
+// position map, stored as -2 - next so that they always read as negative
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::acquireHandle() {
+  if (!Addressable) {  return -1;  }
+  if (this->freeHandle != -1) {
+    int handle = this->freeHandle;
+    this->freeHandle = -2 - this->handlePositions[handle];
+    return handle;
+  }
+  if (this->handleCount == this->handleCapacity) {
+    int newCapacity = (this->handleCapacity > 0) ? this->handleCapacity * 2 : HEAP_MIN_CAPACITY;
+    IndexAlloc indexAlloc(this->alloc);
+    int *newPositions = indexAlloc.allocate(newCapacity);
+    for (int i = 0; i < this->handleCount; i++) {
+      newPositions[i] = this->handlePositions[i];
+    }
+    if (this->handlePositions != nullptr) {
+      indexAlloc.deallocate(this->handlePositions, this->handleCapacity);
+    }
+    this->handlePositions = newPositions;
+    this->handleCapacity = newCapacity;
+  }
+  return this->handleCount++;
+}
+
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::releaseHandle(int handle) {
+  this->handlePositions[handle] = -2 - this->freeHandle;
+  this->freeHandle = handle;
+}
  
 
 // Standard percolation methods for helping elements to find their correct
-// place in the heap
-template<typename NodeContents>
-void Heap<NodeContents>::percolateDown(int index) {
-  int leftChildIndex = this->getLeftChildIndex(index);
-  int rightChildIndex = this->getRightChildIndex(index);
-
-  try {
-    int compareAgainst = this->returnTopper(leftChildIndex, rightChildIndex);
-    if (!this->compare(index, compareAgainst)) {
-      auto tempNode = this->grab(compareAgainst);
-      this->place(this->grab(index), compareAgainst);
-      this->place(tempNode, index);
-      return this->percolateDown(compareAgainst);
-    }
-  } catch (const HeapErrorCodes&) {
-    return;
+// place in the heap. Rather than swapping at every level, the moving element 
+// is held aside and the nodes it passes are shifted into the hole it leaves
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::percolateDown(int index) {
+  int child = this->returnTopper(index);
+  if (child == -1 || !this->compare(child, index)) {  return;  }
+
+  Key priority = this->priorities[index];
+  NodeContents content = std::move(this->payloads[index]);
+  int handle = this->handleAt(index);
+  do {
+    this->moveNode(child, index);
+    index = child;
+    child = this->returnTopper(index);
+  } while (child != -1 && this->moreTop(this->priorities[child], this->payloads[child], priority, content));
+  this->settle(index, priority, content, handle);
+}
+
+// Floyd's bottom-up construction: percolates down every internal node, 
+// starting from the last one, which takes linear time overall
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::heapify() {
+  if (this->occupied < 2) {  return;  }
+  for (int i = this->getParentIndex(this->getLastIndex()); i >= 0; i--) {
+    this->percolateDown(i);
   }
 }
 
-template<typename NodeContents>
-void Heap<NodeContents>::percolateUp(int index) {
-  int parentIndex = this->getParentIndex(index);
-  if (this->hasNode(parentIndex)) {
-    auto currentNode = this->grab(index);
-    auto parentNode = this->grab(parentIndex);
-    if (this->moreTop(currentNode, parentNode)) {
-      this->place(currentNode, parentIndex);
-      this->place(parentNode, index);
-      this->percolateUp(parentIndex);
+// Constructs a range of elements after the occupied cells without restoring 
+// the heap. The caller has to make sure there is room
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename Iterator>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::append(Iterator first, Iterator last, int *handlesOut) {
+  for (; first != last; ++first) {
+    int handle = this->acquireHandle();
+    int index = this->getOpenIndex();
+    this->priorities[index] = (*first).priority;
+    PayloadTraits::construct(this->alloc, this->payloads + index, (*first).content);
+    if (Addressable) {
+      this->slotHandles[index] = handle;
+      this->handlePositions[handle] = index;
     }
+    if (handlesOut != nullptr) {  *handlesOut++ = handle;  }
+    this->occupied++;
+    PQ_COUNT(pushes);
   }
+  PQ_PEAK(this->occupied);
 }
 
-// Helpful methods for comparing two indices in the heap. Returns the 
-// index of the more upper element
-template<typename NodeContents>
-int Heap<NodeContents>::returnTopper(int index1, int index2) {
-  if (!this->hasNode(index1) && !this->hasNode(index2)) {
-    throw NO_CHILD;  
-  } else if (!this->hasNode(index1)) {
-    return index2;
-  } else if (!this->hasNode(index2)) {
-    return index1;
-  } else {
-    auto node1 = this->grab(index1);
-    auto node2 = this->grab(index2);
-    return (this->moreTop(node1, node2)) ? index1 : index2;
+// Returns the index the element finally settled at
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::percolateUp(int index) {
+  int parent = this->getParentIndex(index);
+  if (!this->hasNode(parent) || !this->compare(index, parent)) {  return index;  }
+
+  Key priority = this->priorities[index];
+  NodeContents content = std::move(this->payloads[index]);
+  int handle = this->handleAt(index);
+  do {
+    this->moveNode(parent, index);
+    index = parent;
+    parent = this->getParentIndex(index);
+  } while (this->hasNode(parent) && this->moreTop(priority, content, this->priorities[parent], this->payloads[parent]));
+  this->settle(index, priority, content, handle);
+  return index;
+}
+
+// Helpful method for comparing the children of an index. Returns the index 
+// of the most upper child, or -1 if the node is a leaf. All the candidates 
+// sit next to each other in the priority array.
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::returnTopper(int index) {
+  int first = this->getFirstChildIndex(index);
+  if (first >= this->occupied) {  return -1;  }
+  int end = (first + Arity < this->occupied) ? first + Arity : this->occupied;
+  int topper = first;
+  for (int i = first + 1; i < end; i++) {
+    if (this->compare(i, topper)) {  topper = i;  }
   }
+  return topper;
 }
 
 
 
-// Check to make sure we don't accidentally index outside of our array
-template<typename NodeContents>
-bool Heap<NodeContents>::hasNode(int index) {
-  return (index >= 0) && (index < this->occupied);
+// Number of levels a heap of count elements has
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::levelsFor(int count) {
+  int levels = 1;
+  for (long long reach = Arity; reach < count; reach *= Arity) {  levels++;  }
+  return levels;
 }
 
-// Helper methods for getting children and parents of indices in the heap
-template<typename NodeContents>
-int Heap<NodeContents>::getLeftChildIndex(int index) {
-  return this->getChildIndex(index, true);
+/* topOrder:
+ * The next element in order is always a child of one already found, so 
+ * the candidates (the frontier) are kept in a small heap of indices. Each
+ * step takes the best candidate and adds its children, which finds the 
+ * count topmost elements in O(count * Arity * log(count)) comparisons 
+ * however big the heap is.
+ */
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::topOrder(int count, std::vector<int>& order) {
+  order.clear();
+  if (count > this->occupied) {  count = this->occupied;  }
+  if (count <= 0) {  return;  }
+  order.reserve(count);
+  // std heaps put the largest on top, so "larger" here means less top
+  auto below = [this](int a, int b) {  return this->compare(b, a);  };
+  std::vector<int> frontier(1, 0);
+  while (static_cast<int>(order.size()) < count) {
+    std::pop_heap(frontier.begin(), frontier.end(), below);
+    int index = frontier.back();
+    frontier.pop_back();
+    order.push_back(index);
+    int first = this->getFirstChildIndex(index);
+    for (int child = first; child < first + Arity && child < this->occupied; child++) {
+      frontier.push_back(child);
+      std::push_heap(frontier.begin(), frontier.end(), below);
+    }
+  }
 }
 
-template<typename NodeContents>
-int Heap<NodeContents>::getRightChildIndex(int index) {
-  return this->getChildIndex(index, false);
+// Counts the elements whose priority isn't past priority. Priorities never
+// get more top going down the heap, so a branch can stop at the first one
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::countUpTo(Key priority) {
+  int count = 0;
+  std::vector<int> pending;
+  if (this->occupied > 0) {  pending.push_back(0);  }
+  while (!pending.empty()) {
+    int index = pending.back();
+    pending.pop_back();
+    if (Order::keyMoreTop(priority, this->priorities[index])) {  continue;  }
+    count++;
+    int first = this->getFirstChildIndex(index);
+    for (int child = first; child < first + Arity && child < this->occupied; child++) {
+      pending.push_back(child);
+    }
+  }
+  return count;
 }
 
-template<typename NodeContents>
-int Heap<NodeContents>::getChildIndex(int index, bool isLeft) {
-  if (isLeft) {
-    return 2 * index + 1;
-  } else {
-    return 2 * index + 2;
+// Moves the elements at the indices in order out, in that order, then 
+// packs the rest down to the front of the arrays and heapifies them
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+template<typename OutputIt>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::takeAll(const std::vector<int>& order, OutputIt out) {
+  std::vector<char> taken(this->occupied, 0);
+  for (int index : order) {
+    *out++ = PriorityContainer<NodeContents, Key>(std::move(this->payloads[index]), this->priorities[index]);
+    if (Addressable) {  this->releaseHandle(this->slotHandles[index]);  }
+    taken[index] = 1;
+    PQ_COUNT(pops);
+  }
+  int kept = 0;
+  for (int i = 0; i < this->occupied; i++) {
+    if (taken[i]) {  continue;  }
+    if (i != kept) {  this->moveNode(i, kept);  }
+    kept++;
+  }
+  for (int i = kept; i < this->occupied; i++) {
+    this->destroy(i);
   }
+  this->occupied = kept;
+  this->heapify();
+  this->shrinkIfDrained();
 }
 
-template<typename NodeContents>
-int Heap<NodeContents>::getParentIndex(int index) {
+// Check to make sure we don't accidentally index outside of our array
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+bool Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::hasNode(int index) {
+  return (index >= 0) && (index < this->occupied);
+}
+
+// Helper method for getting the parents of indices in the heap
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+int Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::getParentIndex(int index) {
   if (index == 0) {  return -1;  }
-  return (index - 1) / 2;
+  return (index - 1) / Arity;
 }
 
-// Element moving. Provide some checks and abstract away the array details
-// so that more checking can be easily added if necessary.
-template<typename NodeContents>
-void Heap<NodeContents>::place(PriorityContainer<NodeContents> x, int index) {
-  this->contents[index] = x;
+// Element moving. Abstracts away the parallel arrays and keeps the 
+// position map in sync for Addressable heaps
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::moveNode(int from, int to) {
+  PQ_COUNT(moves);
+  this->priorities[to] = this->priorities[from];
+  this->payloads[to] = std::move(this->payloads[from]);
+  if (Addressable) {
+    this->slotHandles[to] = this->slotHandles[from];
+    this->handlePositions[this->slotHandles[to]] = to;
+  }
 }
 
-template<typename NodeContents>
-PriorityContainer<NodeContents> Heap<NodeContents>::grab(int index) {
-  if (!this->hasNode(index)) {  throw NO_ELEMENT;  }
-  return this->contents[index];
+template<typename NodeContents, typename Order, int Arity, typename Key, bool Addressable, typename Alloc>
+void Heap<NodeContents, Order, Arity, Key, Addressable, Alloc>::settle(int index, Key priority, NodeContents& content, int handle) {
+  this->priorities[index] = priority;
+  this->payloads[index] = std::move(content);
+  if (Addressable) {
+    this->slotHandles[index] = handle;
+    this->handlePositions[handle] = index;
+  }
 }
 
 #endif
@@ -1,8 +1,9 @@
 #include "heap.hpp"
 #include <iostream>
+#include <vector>
 #include "stdlib.h"
 
-bool tiebreaker(int& x1, int p1, int& x2, int p2) {
+bool tiebreaker(int& x1, long long p1, int& x2, long long p2) {
   return x1 > x2;
 }
 
@@ -21,6 +22,108 @@ void popRange(MaxHeap<int, tiebreaker>& m, int num, bool print) {
   }
 }
 
+// Drains a heap and makes sure the priorities come out in order
+template<typename HeapType>
+void checkOrder(HeapType& h, int count, const char *name, bool descending = true) {
+  for (int i = 0; i < count; i++) {
+    h.push(i, rand() % 1000);
+  }
+  auto last = h.pop().priority;
+  bool ordered = true;
+  while (!h.isEmpty()) {
+    auto next = h.pop().priority;
+    ordered = ordered && (descending ? next <= last : next >= last);
+    last = next;
+  }
+  std::cout << name << ": " << (ordered ? "ORDERED" : "OUT OF ORDER") << std::endl;
+}
+
+// Pushes a batch of elements, moves and erases some of them through their
+// handles and checks that what is left still comes out in order
+void checkHandles(int count) {
+  MinHeap<int, tiebreaker, 4, true> h;
+  int *handles = new int[count];
+  for (int i = 0; i < count; i++) {
+    handles[i] = h.push(i, rand() % 1000);
+  }
+  bool consistent = true;
+  for (int i = 0; i < count; i += 3) {
+    h.update(handles[i], rand() % 1000);
+    consistent = consistent && h.contains(handles[i]);
+  }
+  for (int i = 1; i < count; i += 3) {
+    h.erase(handles[i]);
+    consistent = consistent && !h.contains(handles[i]);
+  }
+  int remaining = 0;
+  long long last = -1;
+  while (!h.isEmpty()) {
+    auto next = h.pop();
+    consistent = consistent && (next.priority >= last) && (next.content % 3 != 1);
+    last = next.priority;
+    remaining++;
+  }
+  consistent = consistent && (remaining == count - (count + 1) / 3);
+  std::cout << "HANDLES: " << (consistent ? "CONSISTENT" : "INCONSISTENT") << std::endl;
+  delete[] handles;
+}
+
+// Batch pops have to hand out exactly what popping one at a time would,
+// whichever way they go about it, and leave the handles of the rest usable
+void checkBatchPops(int count) {
+  MinHeap<int, tiebreaker, 4, true> h;
+  std::vector<int> handles(count);
+  for (int i = 0; i < count; i++) {
+    handles[i] = h.push(i, rand() % 1000);
+  }
+  MinHeap<int, tiebreaker, 4, true> reference(h);
+  auto matches = [&](std::vector<PriorityContainer<int>>& batch) {
+    bool same = true;
+    for (auto& element : batch) {
+      auto expected = reference.pop();
+      same = same && element.content == expected.content && element.priority == expected.priority;
+    }
+    return same;
+  };
+
+  bool same = true;
+  std::vector<PriorityContainer<int>> peeked;
+  same = same && h.peekTopK(100, std::back_inserter(peeked)) == 100 && h.getSize() == count;
+  std::vector<PriorityContainer<int>> batch;
+  same = same && h.popK(100, std::back_inserter(batch)) == 100;
+  for (int i = 0; i < 100; i++) {
+    same = same && peeked[i].content == batch[i].content;
+  }
+  same = same && matches(batch);
+
+  // Big enough to rebuild the heap instead of sifting
+  batch.clear();
+  same = same && h.popK(count / 3, std::back_inserter(batch)) == count / 3 && matches(batch);
+  PriorityContainer<int> buffer[10];
+  same = same && h.popK(10, buffer) == 10;
+  std::vector<PriorityContainer<int>> fromBuffer(buffer, buffer + 10);
+  same = same && matches(fromBuffer);
+
+  batch.clear();
+  h.popUntil(700, std::back_inserter(batch));
+  same = same && matches(batch) && h.topPriority() > 700 && reference.topPriority() > 700;
+
+  // Whatever was taken is gone, and the rest can still be moved about
+  for (int i = 0; i < count; i++) {
+    if (h.contains(handles[i])) {  h.update(handles[i], rand() % 1000);  }
+  }
+  long long last = -1;
+  int remaining = 0;
+  while (!h.isEmpty()) {
+    auto next = h.pop();
+    same = same && next.priority >= last;
+    last = next.priority;
+    remaining++;
+  }
+  same = same && remaining == reference.getSize();
+  std::cout << "BATCH POPS: " << (same ? "CONSISTENT" : "INCONSISTENT") << std::endl;
+}
+
 int main() {
   srand(time(0));
   MaxHeap<int, tiebreaker> myHeap;
@@ -34,5 +137,32 @@ int main() {
     popRange(myHeap, c-1, false);
   }
   popRange(myHeap, 100, true);
+
+  MaxHeap<int, tiebreaker, 4> quaternary;
+  MaxHeap<int, tiebreaker, 8> octonary;
+  checkOrder(myHeap, 10000, "BINARY");
+  checkOrder(quaternary, 10000, "4-ARY");
+  checkOrder(octonary, 10000, "8-ARY");
+
+  Heap<int, MinOrder<int, double, noTiebreak<int, double>>, 4, double> doubleKeys;
+  checkOrder(doubleKeys, 10000, "DOUBLE KEYS", false);
+
+  checkHandles(10000);
+  checkBatchPops(10000);
+
+  std::vector<PriorityContainer<int>> elements;
+  for (int i = 0; i < 10000; i++) {
+    elements.push_back(PriorityContainer<int>(i, rand() % 1000));
+  }
+  MaxHeap<int, tiebreaker, 4> bulk(elements.begin(), elements.end());
+  checkOrder(bulk, 10, "BULK BUILT");
+
+  // A small batch sifts its elements up, a big one rebuilds the heap
+  MaxHeap<int, tiebreaker, 4> batched;
+  batched.pushBatch(elements.begin(), elements.begin() + 10);
+  batched.pushBatch(elements.begin(), elements.end());
+  batched.pushBatch(elements.begin(), elements.begin() + 10);
+  bool sized = batched.getSize() == 10020;
+  checkOrder(batched, 10, sized ? "PUSH BATCH" : "PUSH BATCH SIZE WRONG");
 }
 
@@ -0,0 +1,152 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+/*
+ * Hot path counters for the heap and the simulator. Building with
+ * -DPQ_INSTRUMENT (make INSTRUMENT=1 ...) compiles them in, and without it
+ * every counter, timer and hook below disappears, leaving the heap and the
+ * simulator exactly as they were.
+ *
+ * Every Heap counts its own comparisons, element moves (the heap shifts
+ * elements into a hole rather than swapping, so a move is what a swap
+ * would be), resizes, pushes, pops and its peak occupancy. Every Simulator
+ * counts the events it processes by action and keeps a histogram of how
+ * long their handlers took. Both hand their counts to the registry when
+ * they are destroyed, which adds them up by heap type and by action and
+ * writes the lot out as JSON when the program exits, to the file named by
+ * PQ_INSTRUMENT_FILE or to stderr.
+ */
+#ifdef PQ_INSTRUMENT
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+
+struct HeapCounters {
+  long long pushes = 0;
+  long long pops = 0;
+  long long comparisons = 0;
+  long long moves = 0;
+  long long resizes = 0;
+  int peak = 0;
+
+  void add(const HeapCounters& other) {
+    this->pushes += other.pushes;
+    this->pops += other.pops;
+    this->comparisons += other.comparisons;
+    this->moves += other.moves;
+    this->resizes += other.resizes;
+    if (other.peak > this->peak) {  this->peak = other.peak;  }
+  }
+};
+
+// Handler latencies go in power of two buckets: bucket b counts the
+// handlers that took less than 2^b nanoseconds but not less than 2^(b-1)
+const int LATENCY_BUCKETS = 40;
+
+struct EventCounters {
+  long long count = 0;
+  long long nanoseconds = 0;
+  long long latency[LATENCY_BUCKETS] = {0};
+
+  void record(long long nanos) {
+    this->count++;
+    this->nanoseconds += nanos;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && (1LL << bucket) <= nanos) {  bucket++;  }
+    this->latency[bucket]++;
+  }
+  void add(const EventCounters& other) {
+    this->count += other.count;
+    this->nanoseconds += other.nanoseconds;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {  this->latency[i] += other.latency[i];  }
+  }
+};
+
+/*
+ * Process wide totals. Threads hand their counters in under a lock, which
+ * only happens when a heap or simulator goes away. The registry is never
+ * destroyed so objects that outlive main can still report, although
+ * anything reported after the dump at exit is lost.
+ */
+class InstrumentRegistry {
+  private:
+    struct HeapTotals {
+      long long instances = 0;
+      HeapCounters counters;
+    };
+    std::mutex lock;
+    std::map<std::string, HeapTotals> heaps;
+    std::map<std::string, EventCounters> events;
+
+    InstrumentRegistry() {  atexit(dumpAtExit);  }
+    static void dumpAtExit() {  get().dump();  }
+  public:
+    static InstrumentRegistry& get() {
+      static InstrumentRegistry *registry = new InstrumentRegistry();
+      return *registry;
+    }
+
+    void addHeap(const std::string& type, const HeapCounters& counters) {
+      std::lock_guard<std::mutex> hold(this->lock);
+      HeapTotals& totals = this->heaps[type];
+      totals.instances++;
+      totals.counters.add(counters);
+    }
+    void addEvents(const std::string& action, const EventCounters& counters) {
+      if (counters.count == 0) {  return;  }
+      std::lock_guard<std::mutex> hold(this->lock);
+      this->events[action].add(counters);
+    }
+    void dump();
+};
+
+inline void InstrumentRegistry::dump() {
+  std::lock_guard<std::mutex> hold(this->lock);
+  const char *path = getenv("PQ_INSTRUMENT_FILE");
+  FILE *out = (path != nullptr) ? fopen(path, "w") : nullptr;
+  if (out == nullptr) {  out = stderr;  }
+
+  fprintf(out, "{\"heaps\": [");
+  bool first = true;
+  for (auto& entry : this->heaps) {
+    const HeapCounters& c = entry.second.counters;
+    fprintf(out, "%s\n  {\"type\": \"%s\", \"instances\": %lld, \"pushes\": %lld, \"pops\": %lld, "
+            "\"comparisons\": %lld, \"moves\": %lld, \"resizes\": %lld, \"peak_occupancy\": %d, "
+            "\"comparisons_per_op\": %.3f}",
+            first ? "" : ",", entry.first.c_str(), entry.second.instances, c.pushes, c.pops,
+            c.comparisons, c.moves, c.resizes, c.peak,
+            (c.pushes + c.pops > 0) ? static_cast<double>(c.comparisons) / (c.pushes + c.pops) : 0.0);
+    first = false;
+  }
+  fprintf(out, "\n], \"events\": [");
+  first = true;
+  for (auto& entry : this->events) {
+    const EventCounters& c = entry.second;
+    fprintf(out, "%s\n  {\"action\": \"%s\", \"count\": %lld, \"total_ns\": %lld, \"mean_ns\": %.1f, "
+            "\"latency_ns\": [", first ? "" : ",", entry.first.c_str(), c.count, c.nanoseconds,
+            static_cast<double>(c.nanoseconds) / c.count);
+    // Only the buckets something fell in, as upper bound and count
+    bool firstBucket = true;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      if (c.latency[b] == 0) {  continue;  }
+      fprintf(out, "%s{\"below\": %lld, \"count\": %lld}", firstBucket ? "" : ", ", 1LL << b, c.latency[b]);
+      firstBucket = false;
+    }
+    fprintf(out, "]}");
+    first = false;
+  }
+  fprintf(out, "\n]}\n");
+  if (out != stderr) {  fclose(out);  }
+}
+
+#define PQ_COUNT(counter) (this->counters.counter++)
+#define PQ_PEAK(occupancy) do { if ((occupancy) > this->counters.peak) {  this->counters.peak = (occupancy);  } } while (0)
+#else
+#define PQ_COUNT(counter) ((void)0)
+#define PQ_PEAK(occupancy) ((void)0)
+#endif
+
+#endif
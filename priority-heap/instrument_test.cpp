@@ -0,0 +1,53 @@
+#include <iostream>
+#include "heap.hpp"
+#include "simulator.hpp"
+
+bool tiebreaker(int& x1, long long, int& x2, long long) {
+  return x1 > x2;
+}
+
+void printCounters(const char *name, const HeapCounters& c) {
+  std::cout << name << ": PUSHES " << c.pushes << " POPS " << c.pops << " COMPARISONS " << c.comparisons
+            << " MOVES " << c.moves << " RESIZES " << c.resizes << " PEAK " << c.peak << std::endl;
+}
+
+int main() {
+  // Ascending pushes into a min heap never move anything and take one
+  // comparison with the parent each, apart from the first
+  MinHeap<int, tiebreaker> ascending;
+  for (int i = 0; i < 100; i++) {
+    ascending.push(i, i);
+  }
+  const HeapCounters& a = ascending.getCounters();
+  printCounters("ASCENDING", a);
+  std::cout << "ASCENDING: " << ((a.comparisons == 99 && a.moves == 0 && a.peak == 100 && a.resizes == 3) 
+                                 ? "AS EXPECTED" : "UNEXPECTED") << std::endl;
+
+  // Descending pushes move every new element to the top
+  MinHeap<int, tiebreaker> descending(128);
+  int expectedMoves = 0;
+  for (int i = 0; i < 100; i++) {
+    descending.push(i, 100 - i);
+    for (int at = i; at > 0; at = (at - 1) / 2) {  expectedMoves++;  }
+  }
+  while (!descending.isEmpty()) {
+    descending.pop();
+  }
+  const HeapCounters& d = descending.getCounters();
+  printCounters("DESCENDING", d);
+  std::cout << "DESCENDING: " << ((d.pops == 100 && d.resizes == 0 && d.moves >= expectedMoves && d.peak == 100) 
+                                  ? "AS EXPECTED" : "UNEXPECTED") << std::endl;
+
+  // Every event the simulator processes is counted under its action
+  Simulator<> s(50, 40, 60, 130);
+  SimulationResult result = s.simulate();
+  long long counted = 0;
+  for (int action = 0; action < NUM_ACTIONS; action++) {
+    const EventCounters& c = s.getEventCounters(static_cast<ACTION>(action));
+    long long bucketed = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {  bucketed += c.latency[b];  }
+    std::cout << ACTION_NAMES[action] << ": " << c.count << " EVENTS, " << bucketed << " TIMED" << std::endl;
+    counted += c.count;
+  }
+  std::cout << "SIMULATOR: " << (counted == result.events ? "ALL EVENTS COUNTED" : "EVENTS MISSING") << std::endl;
+}
@@ -0,0 +1,160 @@
+#ifndef MULTIQUEUE_H
+#define MULTIQUEUE_H
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <thread>
+#include <utility>
+#include "heap.hpp"
+
+/*
+ * Concurrent, relaxed priority queue for many producers and consumers
+ * (a MultiQueue, Rihani, Sanders and Dementiev 2015). It keeps several
+ * independent heaps (shards), each behind its own try-lock. A push goes
+ * to a random shard. A pop looks at the cached top priority of two random
+ * shards and takes from the better of the two. Threads almost never
+ * contend for the same shard, so throughput scales with the thread count
+ * instead of serializing on one lock.
+ *
+ * The price is that a pop is not guaranteed to return the very best
+ * element, only one near the top. With c shards per thread, the expected
+ * rank of the popped element is O(c * threads) and large rank errors are
+ * exponentially unlikely. No element is ever lost or returned twice, and a
+ * pop only reports empty after finding every shard empty.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity = 4>
+class MultiQueue {
+  private:
+    typedef Heap<Contents, MinOrder<Contents, long long, onTie>, Arity> ShardHeap;
+
+    // The lock and the cached top sit at the front of each shard and a
+    // cache line of padding at the back, so the hot fields of two
+    // neighbouring shards never share a line and threads working on them
+    // don't invalidate each other. hasTop says whether topPriority means
+    // anything, since any priority, LLONG_MAX included, can be pushed
+    struct Shard {
+      std::atomic<bool> locked;
+      std::atomic<bool> hasTop;
+      std::atomic<long long> topPriority;
+      ShardHeap heap;
+      char padding[HEAP_CACHE_LINE];
+
+      Shard() : locked(false), hasTop(false), topPriority(LLONG_MAX) { }
+      bool tryLock() {
+        return !this->locked.load(std::memory_order_relaxed) &&
+               !this->locked.exchange(true, std::memory_order_acquire);
+      }
+      void unlock() {
+        bool empty = this->heap.isEmpty();
+        this->topPriority.store(empty ? LLONG_MAX : this->heap.topPriority(), std::memory_order_relaxed);
+        this->hasTop.store(!empty, std::memory_order_release);
+        this->locked.store(false, std::memory_order_release);
+      }
+    };
+
+    Shard *shards;
+    int numShards;
+
+    int randomShard();
+    bool popFrom(int index, PriorityContainer<Contents>& out);
+  public:
+    MultiQueue(int numThreads, int shardsPerThread = 2);
+    MultiQueue(const MultiQueue&) = delete;
+    MultiQueue& operator=(const MultiQueue&) = delete;
+    ~MultiQueue() {  delete[] this->shards;  }
+
+    void push(Contents c, long long priority);
+    bool tryPop(PriorityContainer<Contents>& out);
+
+    // Only a snapshot while other threads are still pushing or popping
+    bool isEmpty();
+};
+
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity>
+MultiQueue<Contents, onTie, Arity>::MultiQueue(int numThreads, int shardsPerThread) {
+  this->numShards = (numThreads > 0 ? numThreads : 1) * (shardsPerThread > 1 ? shardsPerThread : 2);
+  this->shards = new Shard[this->numShards];
+}
+
+// Per thread xorshift generator, seeded from the thread id so that
+// threads spread out over different shards
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity>
+int MultiQueue<Contents, onTie, Arity>::randomShard() {
+  static thread_local unsigned long long state =
+    std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return static_cast<int>(state % this->numShards);
+}
+
+/* push:
+ * Tries random shards until it gets one whose lock is free.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity>
+void MultiQueue<Contents, onTie, Arity>::push(Contents c, long long priority) {
+  while (true) {
+    Shard& shard = this->shards[this->randomShard()];
+    if (shard.tryLock()) {
+      shard.heap.push(std::move(c), priority);
+      shard.unlock();
+      return;
+    }
+  }
+}
+
+/* tryPop:
+ * Samples two shards and pops from the one whose top is better. When both
+ * samples look empty it falls back to a sweep over every shard, so false
+ * means the queue really was empty at some point during the call.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity>
+bool MultiQueue<Contents, onTie, Arity>::tryPop(PriorityContainer<Contents>& out) {
+  while (true) {
+    int first = this->randomShard();
+    int second = this->randomShard();
+    bool firstHas = this->shards[first].hasTop.load(std::memory_order_relaxed);
+    bool secondHas = this->shards[second].hasTop.load(std::memory_order_relaxed);
+    if (firstHas || secondHas) {
+      int best = first;
+      if (!firstHas || (secondHas && this->shards[second].topPriority.load(std::memory_order_relaxed) <
+                                     this->shards[first].topPriority.load(std::memory_order_relaxed))) {
+        best = second;
+      }
+      if (this->popFrom(best, out)) {  return true;  }
+      continue;
+    }
+
+    bool sawElement = false;
+    for (int i = 0; i < this->numShards; i++) {
+      if (this->shards[i].hasTop.load(std::memory_order_acquire)) {
+        sawElement = true;
+        if (this->popFrom(i, out)) {  return true;  }
+      }
+    }
+    if (!sawElement) {  return false;  }
+  }
+}
+
+// Pops from one shard if its lock is free and it still has something
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity>
+bool MultiQueue<Contents, onTie, Arity>::popFrom(int index, PriorityContainer<Contents>& out) {
+  Shard& shard = this->shards[index];
+  if (!shard.tryLock()) {  return false;  }
+  bool popped = !shard.heap.isEmpty();
+  if (popped) {
+    out.priority = shard.heap.popInto(out.content);
+  }
+  shard.unlock();
+  return popped;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity>
+bool MultiQueue<Contents, onTie, Arity>::isEmpty() {
+  for (int i = 0; i < this->numShards; i++) {
+    if (this->shards[i].hasTop.load(std::memory_order_acquire)) {  return false;  }
+  }
+  return true;
+}
+
+#endif
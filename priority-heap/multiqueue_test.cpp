@@ -0,0 +1,90 @@
+#include "multiqueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+bool tiebreaker(int& x1, long long, int& x2, long long) {
+  return x1 < x2;
+}
+
+/*
+ * Stress test. Every thread pushes its own range of ids with random 
+ * priorities and pops as much as it pushes, interleaved, and then the 
+ * threads drain whatever is left. Afterwards every id has to have been 
+ * popped exactly once. With extremes, a quarter of the priorities are
+ * LLONG_MAX and some LLONG_MIN, which mustn't look like empty shards.
+ */
+bool stress(int numThreads, int perThread, double& seconds, bool extremes = false) {
+  MultiQueue<int, tiebreaker> q(numThreads);
+  int total = numThreads * perThread;
+  std::vector<std::atomic<int>> seen(total);
+  for (auto& s : seen) {  s.store(0);  }
+  std::atomic<int> popped(0);
+
+  auto work = [&](int thread) {
+    unsigned int state = 2166136261u ^ thread;
+    PriorityContainer<int> out;
+    for (int i = 0; i < perThread; i++) {
+      state = state * 1664525u + 1013904223u;
+      long long priority = state % 100000;
+      if (extremes && state % 4 == 0) {  priority = LLONG_MAX;  }
+      if (extremes && state % 16 == 1) {  priority = LLONG_MIN;  }
+      q.push(thread * perThread + i, priority);
+      if (i % 2 == 1) {
+        for (int j = 0; j < 2; j++) {
+          if (q.tryPop(out)) {
+            seen[out.content]++;
+            popped++;
+          }
+        }
+      }
+    }
+    while (popped.load() < total) {
+      if (q.tryPop(out)) {
+        seen[out.content]++;
+        popped++;
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.push_back(std::thread(work, t));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bool exactlyOnce = q.isEmpty();
+  for (auto& s : seen) {
+    exactlyOnce = exactlyOnce && (s.load() == 1);
+  }
+  return exactlyOnce;
+}
+
+int main() {
+  int maxThreads = std::thread::hardware_concurrency();
+  if (maxThreads < 4) {  maxThreads = 4;  }
+  for (int threads = 1; threads <= maxThreads; threads *= 2) {
+    double seconds;
+    int perThread = 200000;
+    bool ok = stress(threads, perThread, seconds);
+    std::cout << "THREADS " << threads << ": " << (ok ? "NO LOSS OR DUPLICATES" : "LOST OR DUPLICATED")
+              << " " << static_cast<long long>(2 * threads * perThread / seconds) << " OPS/S" << std::endl;
+  }
+  double seconds;
+  bool ok = stress(4, 50000, seconds, true);
+  std::cout << "EXTREME PRIORITIES: " << (ok ? "NO LOSS OR DUPLICATES" : "LOST OR DUPLICATED") << std::endl;
+
+  // A lone LLONG_MAX element is still there to be found and popped
+  MultiQueue<int, tiebreaker> q(2);
+  q.push(7, LLONG_MAX);
+  PriorityContainer<int> out;
+  bool found = !q.isEmpty() && q.tryPop(out) && out.content == 7 && out.priority == LLONG_MAX && q.isEmpty();
+  std::cout << "LLONG_MAX ALONE: " << (found ? "POPPED" : "LOST") << std::endl;
+}
@@ -0,0 +1,107 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+#include <vector>
+
+/*
+ * Infection state of every computer in the network, packed 64 to a word.
+ *
+ * Alongside the bits it keeps a live count of the infected computers, in
+ * total and on each side of the IDS (side 0 is the lower half of the ids,
+ * side 1 the upper half), so questions like "is more than half of the
+ * network infected" take constant time instead of a scan. The counters are
+ * only touched when a bit actually flips. audit recounts everything with
+ * popcounts to check them.
+ */
+class NetworkState {
+  private:
+    std::vector<unsigned long long> words;
+    int size;
+    int split;
+    int infected;
+    int infectedOnSide[2];
+
+    static unsigned long long bit(int computer) {  return 1ULL << (computer & 63);  }
+    int countRange(int first, int last);
+  public:
+    NetworkState() : NetworkState(0) { }
+    explicit NetworkState(int size) {  this->reset(size);  }
+
+    // Clears the network and resizes it, keeping the storage if it fits
+    void reset(int size);
+
+    bool isInfected(int computer) {  return (this->words[computer >> 6] & bit(computer)) != 0;  }
+    // Both return whether the computer actually changed state
+    bool infect(int computer);
+    bool repair(int computer);
+
+    int sideOf(int computer) {  return (computer >= this->split) ? 1 : 0;  }
+    int getSize() {  return this->size;  }
+    int getInfected() {  return this->infected;  }
+    int getInfectedOnSide(int side) {  return this->infectedOnSide[side];  }
+
+    bool audit();
+};
+
+inline void NetworkState::reset(int size) {
+  this->size = size;
+  this->split = size / 2;
+  this->words.assign((size + 63) / 64, 0);
+  this->infected = 0;
+  this->infectedOnSide[0] = 0;
+  this->infectedOnSide[1] = 0;
+}
+
+inline bool NetworkState::infect(int computer) {
+  unsigned long long& word = this->words[computer >> 6];
+  if (word & bit(computer)) {  return false;  }
+  word |= bit(computer);
+  this->infected++;
+  this->infectedOnSide[this->sideOf(computer)]++;
+  return true;
+}
+
+inline bool NetworkState::repair(int computer) {
+  unsigned long long& word = this->words[computer >> 6];
+  if (!(word & bit(computer))) {  return false;  }
+  word &= ~bit(computer);
+  this->infected--;
+  this->infectedOnSide[this->sideOf(computer)]--;
+  return true;
+}
+
+// Popcount of the computers in [first, last), masking the partial words
+// at either end
+inline int NetworkState::countRange(int first, int last) {
+  if (first >= last) {  return 0;  }
+  int firstWord = first >> 6;
+  int lastWord = (last - 1) >> 6;
+  unsigned long long firstMask = ~0ULL << (first & 63);
+  unsigned long long lastMask = ((last & 63) == 0) ? ~0ULL : bit(last) - 1;
+  if (firstWord == lastWord) {
+    return __builtin_popcountll(this->words[firstWord] & firstMask & lastMask);
+  }
+  int count = __builtin_popcountll(this->words[firstWord] & firstMask);
+  for (int w = firstWord + 1; w < lastWord; w++) {
+    count += __builtin_popcountll(this->words[w]);
+  }
+  return count + __builtin_popcountll(this->words[lastWord] & lastMask);
+}
+
+/* audit:
+ * Recounts the infected computers on both sides with popcounts and checks
+ * them against the live counters. Also checks that no bit past the end of
+ * the network is set. Costs a pass over the words, so it is meant for
+ * tests and debugging, not for every event.
+ */
+inline bool NetworkState::audit() {
+  int lower = this->countRange(0, this->split);
+  int upper = this->countRange(this->split, this->size);
+  int total = 0;
+  for (unsigned long long word : this->words) {
+    total += __builtin_popcountll(word);
+  }
+  return lower == this->infectedOnSide[0] && upper == this->infectedOnSide[1] &&
+         total == this->infected && lower + upper == total;
+}
+
+#endif
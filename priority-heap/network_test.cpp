@@ -0,0 +1,46 @@
+#include "network.hpp"
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Infects and repairs random computers on a network and on a plain bool
+// array side by side, and checks the counters and the audit against a
+// straight count of the array after every step
+bool checkAgainstArray(int size, int steps, std::mt19937& mt) {
+  NetworkState network(size);
+  std::vector<bool> computers(size, false);
+  std::uniform_int_distribution<int> pick(0, size - 1);
+  bool same = true;
+  for (int i = 0; i < steps; i++) {
+    int computer = pick(mt);
+    bool wrong;
+    if (mt() % 2 == 0) {
+      wrong = network.infect(computer) != !computers[computer];
+      computers[computer] = true;
+    } else {
+      wrong = network.repair(computer) != computers[computer];
+      computers[computer] = false;
+    }
+    int sides[2] = {0, 0};
+    for (int c = 0; c < size; c++) {
+      if (computers[c]) {  sides[c >= size / 2]++;  }
+    }
+    same = same && !wrong && network.isInfected(computer) == computers[computer] &&
+           network.getInfectedOnSide(0) == sides[0] && network.getInfectedOnSide(1) == sides[1] &&
+           network.getInfected() == sides[0] + sides[1] && network.audit();
+  }
+  return same;
+}
+
+int main() {
+  std::mt19937 mt(130);
+  std::cout << "ONE COMPUTER: " << (checkAgainstArray(1, 100, mt) ? "CONSISTENT" : "INCONSISTENT") << std::endl;
+  std::cout << "PARTIAL WORD: " << (checkAgainstArray(37, 1000, mt) ? "CONSISTENT" : "INCONSISTENT") << std::endl;
+  std::cout << "SPLIT IN WORD: " << (checkAgainstArray(200, 5000, mt) ? "CONSISTENT" : "INCONSISTENT") << std::endl;
+  std::cout << "WHOLE WORDS: " << (checkAgainstArray(256, 5000, mt) ? "CONSISTENT" : "INCONSISTENT") << std::endl;
+
+  NetworkState network(100);
+  network.infect(99);
+  network.reset(64);
+  std::cout << "RESET: " << ((network.getInfected() == 0 && network.audit()) ? "CLEARED" : "NOT CLEARED") << std::endl;
+}
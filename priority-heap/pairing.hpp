@@ -0,0 +1,380 @@
+#ifndef PAIRING_H
+#define PAIRING_H
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "heap.hpp"
+
+// Nodes are carved out of chunks of this many at a time
+const int PAIRING_CHUNK_NODES = 1024;
+
+/*
+ * Pairing heap, for when queues have to be merged. Where the array backed
+ * Heap can only merge by popping one queue into the other, a pairing heap
+ * is a tree of nodes and merging two is a single link of their roots:
+ *
+ *   push, meld, decreaseKey   O(1)
+ *   pop                       O(log n) amortized
+ *
+ * Has the same interface and ordering as PriorityQueue: lowest priority
+ * first, with ties settled by the tiebreaker. push hands out a handle to
+ * the element that stays valid until the element is popped or erased, and
+ * can be used to bring its priority forward with decreaseKey or to erase
+ * it. Handles stay valid across a meld, on the heap that was melded into.
+ *
+ * Nodes come out of a pool of chunks owned by the heap, and popped ones
+ * are kept on a free list for the next push, so a steady push/pop pattern
+ * doesn't allocate. A meld takes over the other heap's chunks and free
+ * list as well as its tree, which is what keeps it O(1) and the handles
+ * valid. Copying a heap clones its tree node by node, and the handles of
+ * the original don't work on the copy.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie>
+class PairingHeap {
+  private:
+    typedef MinOrder<Contents, long long, onTie> Order;
+
+    // prev is the parent for the first child in a list of siblings and the
+    // previous sibling for the others, which is what lets a node be cut out
+    // in constant time. Free nodes are chained through next
+    struct Node {
+      long long priority;
+      Node *child;
+      Node *next;
+      Node *prev;
+      Contents content;
+    };
+    struct Chunk {
+      Chunk *next;
+      typename std::aligned_storage<sizeof(Node), alignof(Node)>::type nodes[PAIRING_CHUNK_NODES];
+    };
+
+    Node *root;
+    int occupied;
+    Chunk *chunks;
+    Chunk *lastChunk;
+    int usedInChunk;
+    Node *freeNodes;
+    Node *lastFree;
+    // Scratch space for pop's pairing passes, kept to avoid reallocating
+    std::vector<Node*> pairs;
+
+    static bool before(Node *a, Node *b) {
+      return Order::moreTop(a->priority, a->content, b->priority, b->content);
+    }
+    Node *link(Node *a, Node *b);
+    Node *mergePairs(Node *first);
+    void cut(Node *node);
+
+    Node *allocateNode();
+    void freeNode(Node *node);
+    void destroyTree(Node *top);
+    Node *cloneTree(Node *top);
+    Node *insert(Contents&& content, long long priority);
+    void removeRoot();
+  public:
+    typedef Node *Handle;
+
+    PairingHeap() : root(nullptr), occupied(0), chunks(nullptr), lastChunk(nullptr),
+                    usedInChunk(PAIRING_CHUNK_NODES), freeNodes(nullptr), lastFree(nullptr) { }
+    PairingHeap(int size) : PairingHeap() {  (void)size;  }
+    PairingHeap(const PairingHeap& other) : PairingHeap() {
+      this->root = this->cloneTree(other.root);
+      this->occupied = other.occupied;
+    }
+    PairingHeap& operator=(const PairingHeap& other) {
+      if (this != &other) {
+        this->clear();
+        this->root = this->cloneTree(other.root);
+        this->occupied = other.occupied;
+      }
+      return *this;
+    }
+    PairingHeap(PairingHeap&& other) : PairingHeap() {  this->meld(other);  }
+    PairingHeap& operator=(PairingHeap&& other) {
+      if (this != &other) {
+        this->clear();
+        this->meld(other);
+      }
+      return *this;
+    }
+    ~PairingHeap();
+
+    Handle push(Contents& c, long long priority) {  return this->insert(Contents(c), priority);  }
+    Handle push(Contents&& c, long long priority) {  return this->insert(std::move(c), priority);  }
+    template<typename... Args>
+    Handle emplace(long long priority, Args&&... args) {
+      return this->insert(Contents(std::forward<Args>(args)...), priority);
+    }
+
+    PriorityContainer<Contents> pop();
+    Contents popContent() {  return this->pop().content;  }
+    long long popInto(Contents& out);
+    Contents& top();
+    long long topPriority();
+
+    bool isEmpty() {  return this->occupied == 0;  }
+    int getSize() {  return this->occupied;  }
+    // Destroys every element but keeps the nodes for reuse
+    void clear();
+
+    // Moves every element of other into this heap, leaving other empty
+    void meld(PairingHeap& other);
+    // The new priority can't be later than the old one
+    void decreaseKey(Handle handle, long long priority);
+    void erase(Handle handle);
+    long long getPriority(Handle handle) {  return handle->priority;  }
+};
+
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+PairingHeap<Contents, onTie>::~PairingHeap() {
+  this->destroyTree(this->root);
+  while (this->chunks != nullptr) {
+    Chunk *next = this->chunks->next;
+    delete this->chunks;
+    this->chunks = next;
+  }
+}
+
+// Makes the later of two roots the first child of the other
+template<typename Contents, Tiebreaker<Contents> onTie>
+typename PairingHeap<Contents, onTie>::Node *PairingHeap<Contents, onTie>::link(Node *a, Node *b) {
+  if (a == nullptr) {  return b;  }
+  if (b == nullptr) {  return a;  }
+  if (before(b, a)) {  std::swap(a, b);  }
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != nullptr) {  a->child->prev = b;  }
+  a->child = b;
+  a->next = a->prev = nullptr;
+  return a;
+}
+
+/* mergePairs:
+ * The standard two pass pairing: link the siblings in pairs from left to
+ * right, then link the results from right to left into a single tree.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie>
+typename PairingHeap<Contents, onTie>::Node *PairingHeap<Contents, onTie>::mergePairs(Node *first) {
+  this->pairs.clear();
+  while (first != nullptr) {
+    Node *a = first;
+    Node *b = a->next;
+    first = (b != nullptr) ? b->next : nullptr;
+    a->next = a->prev = nullptr;
+    if (b != nullptr) {  b->next = b->prev = nullptr;  }
+    this->pairs.push_back(this->link(a, b));
+  }
+  Node *merged = nullptr;
+  for (int i = static_cast<int>(this->pairs.size()) - 1; i >= 0; i--) {
+    merged = this->link(this->pairs[i], merged);
+  }
+  return merged;
+}
+
+// Unhooks a node that isn't the root, along with its subtree
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::cut(Node *node) {
+  if (node->prev->child == node) {
+    node->prev->child = node->next;
+  } else {
+    node->prev->next = node->next;
+  }
+  if (node->next != nullptr) {  node->next->prev = node->prev;  }
+  node->next = node->prev = nullptr;
+}
+
+// Takes a node off the free list, or the next one out of the last chunk
+template<typename Contents, Tiebreaker<Contents> onTie>
+typename PairingHeap<Contents, onTie>::Node *PairingHeap<Contents, onTie>::allocateNode() {
+  if (this->freeNodes != nullptr) {
+    Node *node = this->freeNodes;
+    this->freeNodes = node->next;
+    if (this->freeNodes == nullptr) {  this->lastFree = nullptr;  }
+    return node;
+  }
+  if (this->usedInChunk == PAIRING_CHUNK_NODES) {
+    Chunk *chunk = new Chunk;
+    chunk->next = this->chunks;
+    if (this->chunks == nullptr) {  this->lastChunk = chunk;  }
+    this->chunks = chunk;
+    this->usedInChunk = 0;
+  }
+  return reinterpret_cast<Node *>(&this->chunks->nodes[this->usedInChunk++]);
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::freeNode(Node *node) {
+  node->content.~Contents();
+  node->next = this->freeNodes;
+  if (this->freeNodes == nullptr) {  this->lastFree = node;  }
+  this->freeNodes = node;
+}
+
+// Frees every node under top without recursing, since trees can be deep
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::destroyTree(Node *top) {
+  if (top == nullptr) {  return;  }
+  std::vector<Node*> pending(1, top);
+  while (!pending.empty()) {
+    Node *node = pending.back();
+    pending.pop_back();
+    for (Node *child = node->child; child != nullptr; child = child->next) {
+      pending.push_back(child);
+    }
+    this->freeNode(node);
+  }
+}
+
+// Copies a tree into nodes of this heap, keeping its shape
+template<typename Contents, Tiebreaker<Contents> onTie>
+typename PairingHeap<Contents, onTie>::Node *PairingHeap<Contents, onTie>::cloneTree(Node *top) {
+  if (top == nullptr) {  return nullptr;  }
+  auto copyOf = [this](Node *source) {
+    Node *node = this->allocateNode();
+    new (&node->content) Contents(source->content);
+    node->priority = source->priority;
+    node->child = node->next = node->prev = nullptr;
+    return node;
+  };
+  Node *copy = copyOf(top);
+  std::vector<std::pair<Node*, Node*>> pending(1, std::make_pair(top, copy));
+  while (!pending.empty()) {
+    Node *source = pending.back().first;
+    Node *target = pending.back().second;
+    pending.pop_back();
+    Node *previous = target;
+    for (Node *child = source->child; child != nullptr; child = child->next) {
+      Node *childCopy = copyOf(child);
+      childCopy->prev = previous;
+      if (previous == target) {
+        target->child = childCopy;
+      } else {
+        previous->next = childCopy;
+      }
+      previous = childCopy;
+      pending.push_back(std::make_pair(child, childCopy));
+    }
+  }
+  return copy;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+typename PairingHeap<Contents, onTie>::Node *PairingHeap<Contents, onTie>::insert(Contents&& content, long long priority) {
+  Node *node = this->allocateNode();
+  new (&node->content) Contents(std::move(content));
+  node->priority = priority;
+  node->child = node->next = node->prev = nullptr;
+  this->root = this->link(this->root, node);
+  this->occupied++;
+  return node;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::removeRoot() {
+  Node *old = this->root;
+  this->root = this->mergePairs(old->child);
+  this->freeNode(old);
+  this->occupied--;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+PriorityContainer<Contents> PairingHeap<Contents, onTie>::pop() {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  PriorityContainer<Contents> toReturn(std::move(this->root->content), this->root->priority);
+  this->removeRoot();
+  return toReturn;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+long long PairingHeap<Contents, onTie>::popInto(Contents& out) {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  long long priority = this->root->priority;
+  out = std::move(this->root->content);
+  this->removeRoot();
+  return priority;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+Contents& PairingHeap<Contents, onTie>::top() {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  return this->root->content;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+long long PairingHeap<Contents, onTie>::topPriority() {
+  if (this->isEmpty()) {  throw NO_ELEMENT;  }
+  return this->root->priority;
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::clear() {
+  this->destroyTree(this->root);
+  this->root = nullptr;
+  this->occupied = 0;
+}
+
+/* meld:
+ * Links the two roots and takes over other's node pool: its chunks are
+ * spliced in behind the one currently being carved up and its free list
+ * is appended to ours. The rest of other's last chunk goes unused.
+ */
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::meld(PairingHeap& other) {
+  if (this == &other) {  return;  }
+  this->root = this->link(this->root, other.root);
+  this->occupied += other.occupied;
+
+  if (other.chunks != nullptr) {
+    if (this->chunks == nullptr) {
+      this->chunks = other.chunks;
+      this->lastChunk = other.lastChunk;
+      this->usedInChunk = other.usedInChunk;
+    } else {
+      other.lastChunk->next = this->chunks->next;
+      this->chunks->next = other.chunks;
+      if (this->lastChunk == this->chunks) {  this->lastChunk = other.lastChunk;  }
+    }
+  }
+  if (other.freeNodes != nullptr) {
+    if (this->freeNodes == nullptr) {
+      this->freeNodes = other.freeNodes;
+    } else {
+      this->lastFree->next = other.freeNodes;
+    }
+    this->lastFree = other.lastFree;
+  }
+
+  other.root = nullptr;
+  other.occupied = 0;
+  other.chunks = other.lastChunk = nullptr;
+  other.usedInChunk = PAIRING_CHUNK_NODES;
+  other.freeNodes = other.lastFree = nullptr;
+}
+
+// Cuts the node's subtree out, which is still a valid heap, and links it
+// back in at the top with its new priority
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::decreaseKey(Handle handle, long long priority) {
+  handle->priority = priority;
+  if (handle == this->root) {  return;  }
+  this->cut(handle);
+  this->root = this->link(this->root, handle);
+}
+
+template<typename Contents, Tiebreaker<Contents> onTie>
+void PairingHeap<Contents, onTie>::erase(Handle handle) {
+  if (handle == this->root) {
+    this->removeRoot();
+    return;
+  }
+  this->cut(handle);
+  Node *children = this->mergePairs(handle->child);
+  this->root = this->link(this->root, children);
+  this->freeNode(handle);
+  this->occupied--;
+}
+
+#endif
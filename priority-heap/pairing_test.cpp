@@ -0,0 +1,112 @@
+#include "pairing.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+bool tiebreaker(int& x1, long long, int& x2, long long) {
+  return x1 < x2;
+}
+
+// Drains both queues and checks they hand out the same elements in the
+// same order. The tiebreaker makes the order total, so they have to
+template<typename Queue1, typename Queue2>
+bool sameOrder(Queue1& a, Queue2& b) {
+  bool same = a.getSize() == b.getSize();
+  while (same && !a.isEmpty() && !b.isEmpty()) {
+    auto x = a.pop();
+    auto y = b.pop();
+    same = x.content == y.content && x.priority == y.priority;
+  }
+  return same && a.isEmpty() && b.isEmpty();
+}
+
+int main() {
+  std::mt19937 mt(130);
+  std::uniform_int_distribution<int> priority(0, 1000000);
+
+  // Plain pushes and pops, interleaved
+  PairingHeap<int, tiebreaker> pairing;
+  MinHeap<int, tiebreaker> heap;
+  for (int i = 0; i < 100000; i++) {
+    long long p = priority(mt);
+    pairing.push(i, p);
+    heap.push(i, p);
+    if (i % 3 == 0) {
+      auto x = pairing.pop();
+      auto y = heap.pop();
+      if (x.content != y.content) {  std::cout << "POP MISMATCH AT " << i << std::endl;  }
+    }
+  }
+  std::cout << "PUSH/POP: " << (sameOrder(pairing, heap) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+
+  // Shards melded back together come out like one queue holding everything
+  std::vector<PairingHeap<int, tiebreaker>> shards(8);
+  for (int i = 0; i < 100000; i++) {
+    long long p = priority(mt);
+    shards[i % 8].push(i, p);
+    heap.push(i, p);
+  }
+  for (int i = 1; i < 8; i++) {
+    shards[0].meld(shards[i]);
+  }
+  bool emptied = true;
+  for (int i = 1; i < 8; i++) {
+    emptied = emptied && shards[i].isEmpty();
+  }
+  std::cout << "MELD: " << (emptied && sameOrder(shards[0], heap) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+
+  // Decreases and erases through handles, which have to survive a meld
+  PairingHeap<int, tiebreaker> left, right;
+  MinHeap<int, tiebreaker, 2, true> addressable;
+  std::vector<PairingHeap<int, tiebreaker>::Handle> handles;
+  std::vector<int> heapHandles;
+  for (int i = 0; i < 50000; i++) {
+    long long p = priority(mt);
+    handles.push_back((i % 2 == 0 ? left : right).push(i, p));
+    heapHandles.push_back(addressable.push(i, p));
+  }
+  left.meld(right);
+  for (int i = 0; i < 50000; i += 2) {
+    long long p = left.getPriority(handles[i]) - priority(mt) % 1000;
+    left.decreaseKey(handles[i], p);
+    addressable.update(heapHandles[i], p);
+  }
+  for (int i = 1; i < 50000; i += 7) {
+    left.erase(handles[i]);
+    addressable.erase(heapHandles[i]);
+  }
+  std::cout << "DECREASE/ERASE: " << (sameOrder(left, addressable) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+
+  // A copy is independent of the original
+  PairingHeap<int, tiebreaker> original;
+  for (int i = 0; i < 1000; i++) {
+    original.push(i, priority(mt));
+  }
+  PairingHeap<int, tiebreaker> copy(original);
+  copy.pop();
+  PairingHeap<int, tiebreaker> assigned;
+  assigned = original;
+  std::cout << "COPY: " << (copy.getSize() == 999 && sameOrder(original, assigned) ? "INDEPENDENT" : "SHARED") << std::endl;
+
+  // Merging two big queues, melding against popping one into the other
+  PairingHeap<int, tiebreaker> a, b;
+  MinHeap<int, tiebreaker> c, d;
+  for (int i = 0; i < 1000000; i++) {
+    long long p = priority(mt);
+    (i % 2 == 0 ? a : b).push(i, p);
+    (i % 2 == 0 ? c : d).push(i, p);
+  }
+  auto start = std::chrono::steady_clock::now();
+  a.meld(b);
+  double meldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  int content;
+  while (!d.isEmpty()) {
+    long long p = d.popInto(content);
+    c.push(content, p);
+  }
+  double heapSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "MERGING 2 x 500000: MELD " << meldSeconds << "s MINHEAP " << heapSeconds << "s, "
+            << (sameOrder(a, c) ? "MATCHES HEAP" : "MISMATCH") << std::endl;
+}
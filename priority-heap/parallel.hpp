@@ -0,0 +1,390 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include "simulator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+ * Conservative parallel version of Simulator. The computers are dealt out
+ * round robin to partitions, one per thread, and every event belongs to
+ * the partition owning the state it touches: attacks deployed from a
+ * computer to the computer's partition, attacks executed on a computer and
+ * repairs to the target's, notifications to partition 0, which keeps the
+ * sysadmin and the attacks from outside. Each partition has its own event
+ * queue and its own copy of the network, of which it only ever touches the
+ * computers it owns.
+ *
+ * Nothing is ever scheduled less than the lookahead into the future (100,
+ * or the lightest link of the topology if that is less), so once every
+ * partition agrees on the earliest pending time, they can all process
+ * everything due before that plus the lookahead without hearing from each
+ * other. Events for other partitions go into the owner's lock free mailbox
+ * and are picked up at the end of the window.
+ *
+ * Partitions process events through the same EventRules as Simulator,
+ * the random numbers come from per event streams (see EventStream) and
+ * ties between events are settled the same way everywhere, so every
+ * partition does exactly what the sequential simulator does with the same
+ * computers. What a partition can't see is the whole network, so it logs
+ * how every event changed the infection count, and at the end of each
+ * window one thread merges the logs in sequential order and replays the
+ * counts. The end of the run is found exactly, events that ran past it in
+ * other partitions are just dropped, and the outcome, end time and event
+ * count are the ones Simulator would give for the same seed.
+ * Parallel runs don't write a trace.
+ */
+
+// Event headed for another partition
+struct ParallelMessage {
+  ParallelMessage *next;
+  long long time;
+  Event event;
+};
+
+/*
+ * Many senders, one receiver. Sending pushes onto a Treiber stack with a
+ * compare and swap, and the receiver swaps the whole stack out at once.
+ * The order messages arrive in doesn't matter, the receiving queue sorts
+ * them anyway.
+ */
+class Mailbox {
+  private:
+    std::atomic<ParallelMessage*> head;
+  public:
+    Mailbox() : head(nullptr) { }
+
+    void post(ParallelMessage *m) {
+      ParallelMessage *top = this->head.load(std::memory_order_relaxed);
+      do {
+        m->next = top;
+      } while (!this->head.compare_exchange_weak(top, m, std::memory_order_release, std::memory_order_relaxed));
+    }
+    ParallelMessage *takeAll() {  return this->head.exchange(nullptr, std::memory_order_acquire);  }
+};
+
+// Messages are only in flight for a window, so the sender hands them out
+// from chunks and takes them all back at once when the window is over
+class MessagePool {
+  private:
+    static const int CHUNK_MESSAGES = 1024;
+    std::vector<std::unique_ptr<ParallelMessage[]>> chunks;
+    size_t used = 0;
+  public:
+    ParallelMessage *allocate() {
+      if (this->used == this->chunks.size() * CHUNK_MESSAGES) {
+        this->chunks.emplace_back(new ParallelMessage[CHUNK_MESSAGES]);
+      }
+      ParallelMessage *m = &this->chunks[this->used / CHUNK_MESSAGES][this->used % CHUNK_MESSAGES];
+      this->used++;
+      return m;
+    }
+    void reset() {  this->used = 0;  }
+};
+
+// Spinning barrier. The last thread to arrive runs the completion before
+// letting the others go, and they all see whatever it wrote
+class WindowBarrier {
+  private:
+    int threads = 1;
+    std::atomic<int> waiting;
+    std::atomic<int> generation;
+  public:
+    WindowBarrier() : waiting(0), generation(0) { }
+    void setThreads(int threads) {  this->threads = threads;  }
+
+    template<typename Completion>
+    void wait(Completion complete) {
+      int current = this->generation.load(std::memory_order_acquire);
+      if (this->waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == this->threads) {
+        this->waiting.store(0, std::memory_order_relaxed);
+        complete();
+        this->generation.store(current + 1, std::memory_order_release);
+      } else {
+        while (this->generation.load(std::memory_order_acquire) == current) {
+          std::this_thread::yield();
+        }
+      }
+    }
+};
+
+template<typename EventQueue = SIM_EVENT_QUEUE>
+class ParallelSimulator {
+  private:
+    // What an event did to the infection counts, for the replay
+    struct Logged {
+      long long time;
+      Event event;
+      int infected;
+      bool hit;
+    };
+
+    struct Partition {
+      int index;
+      EventQueue q;
+      NetworkState network;
+      EventStream stream;
+      long long t = 0;
+      long long next = LLONG_MAX;
+      std::vector<Logged> log;
+      Mailbox inbox;
+      MessagePool outgoing;
+      char padding[HEAP_CACHE_LINE];
+    };
+
+    // Simulation characteristics from the user
+    long long maxTime = 8640000000;
+    int numComputers;
+    int attackProbability;
+    int detectProbability;
+    unsigned int seed;
+    const Topology *topology = nullptr;
+    long long lookahead = 100;
+
+    // Only partition 0 processes the events that schedule repairs, so it
+    // is the only one that gets to see the sysadmin
+    SysAdmin sysadmin;
+    std::vector<std::unique_ptr<Partition>> partitions;
+    WindowBarrier barrier;
+
+    // Written by whichever thread finishes a window, between barriers
+    long long windowEnd = 0;
+    bool done = false;
+    SimulationResult result;
+
+    // The whole network's infection counts as of the last replayed event
+    int infected = 0;
+    bool hasInfected = false;
+    long long t = 0;
+    long long events = 0;
+
+    int ownerOf(const Event& e);
+    void send(Partition& p, Event& e, long long t);
+    void work(int index);
+    void startWindow();
+    void endWindow();
+    bool finished(long long time);
+
+    ModelState modelState(Partition& p) {
+      return ModelState{p.t, this->seed, this->numComputers, this->attackProbability, this->detectProbability,
+                        this->topology, &p.network, (p.index == 0) ? &this->sysadmin : nullptr, &p.stream};
+    }
+    void process(Partition& p, Event& e);
+  public:
+    ParallelSimulator(int numComputers, int attackProbability, int detectProbability, int threads,
+                      unsigned int seed = static_cast<unsigned int>(time(0)));
+    ParallelSimulator(const ParallelSimulator&) = delete;
+    ParallelSimulator& operator=(const ParallelSimulator&) = delete;
+
+    // The topology has to have numComputers computers and outlive the run.
+    // Its lightest link bounds the lookahead
+    void setTopology(const Topology *topology);
+
+    // Both run from the start, on threads - 1 new threads and the caller
+    void run();
+    SimulationResult simulate();
+};
+
+template<typename EventQueue>
+ParallelSimulator<EventQueue>::ParallelSimulator(int numComputers, int attackProbability, int detectProbability,
+                                                 int threads, unsigned int seed)
+  : numComputers(numComputers), attackProbability(attackProbability), detectProbability(detectProbability),
+    seed(seed) {
+  if (threads < 1) {  threads = 1;  }
+  for (int i = 0; i < threads; i++) {
+    this->partitions.emplace_back(new Partition());
+    this->partitions.back()->index = i;
+  }
+  this->barrier.setThreads(threads);
+}
+
+template<typename EventQueue>
+void ParallelSimulator<EventQueue>::setTopology(const Topology *topology) {
+  this->topology = topology;
+  this->lookahead = 100;
+  if (topology == nullptr) {  return;  }
+  for (int c = 0; c < topology->getSize(); c++) {
+    for (int i = 0; i < topology->getDegree(c); i++) {
+      this->lookahead = std::min<long long>(this->lookahead, topology->getWeight(topology->getLink(c, i)));
+    }
+  }
+}
+
+template<typename EventQueue>
+void ParallelSimulator<EventQueue>::run() {
+  std::cout << "STARTING SIMULATION" << std::endl;
+  printOutcome(this->simulate().outcome);
+}
+
+template<typename EventQueue>
+SimulationResult ParallelSimulator<EventQueue>::simulate() {
+  for (auto& p : this->partitions) {
+    p->q.clear();
+    p->network.reset(this->numComputers);
+    p->t = 0;
+    p->log.clear();
+    p->outgoing.reset();
+  }
+  this->infected = 0;
+  this->hasInfected = false;
+  this->t = 0;
+  this->events = 0;
+  this->done = false;
+  this->sysadmin = SysAdmin();
+
+  Partition& first = *this->partitions[0];
+  ModelState state = this->modelState(first);
+  auto schedule = [this, &first](Event& e, long long t) {  this->send(first, e, t);  };
+  makeRules(state, schedule).start();
+  first.next = first.q.topPriority();
+  this->startWindow();
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < this->partitions.size(); i++) {
+    threads.emplace_back(&ParallelSimulator::work, this, static_cast<int>(i));
+  }
+  this->work(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return this->result;
+}
+
+/* work:
+ * One partition's side of every window: process everything due before
+ * the window ends, then pick up what the others sent once they're all
+ * done sending, and wait for the verdict on the window.
+ */
+template<typename EventQueue>
+void ParallelSimulator<EventQueue>::work(int index) {
+  Partition& p = *this->partitions[index];
+  Event e;
+  while (!this->done) {
+    while (!p.q.isEmpty() && p.q.topPriority() < this->windowEnd) {
+      p.t = p.q.popInto(e);
+      this->process(p, e);
+    }
+    this->barrier.wait([]() { });
+
+    for (ParallelMessage *m = p.inbox.takeAll(); m != nullptr; m = m->next) {
+      p.q.push(m->event, m->time);
+    }
+    p.next = p.q.isEmpty() ? LLONG_MAX : p.q.topPriority();
+    this->barrier.wait([this]() {  this->endWindow();  });
+    p.outgoing.reset();
+  }
+}
+
+// The next window starts at the earliest pending event anywhere
+template<typename EventQueue>
+void ParallelSimulator<EventQueue>::startWindow() {
+  long long next = LLONG_MAX;
+  for (auto& p : this->partitions) {
+    next = std::min(next, p->next);
+  }
+  if (next == LLONG_MAX) {
+    this->done = true;
+    this->result = SimulationResult{QUEUE_EMPTY, this->t, this->events};
+  } else if (next > this->maxTime) {
+    this->done = true;
+    this->result = SimulationResult{TIMED_OUT, next, this->events};
+  } else {
+    this->windowEnd = next + this->lookahead;
+  }
+}
+
+// Checks the end conditions as Simulator::fetch does before every event
+template<typename EventQueue>
+bool ParallelSimulator<EventQueue>::finished(long long time) {
+  if (this->infected > (this->numComputers + 1) / 2) {
+    this->result = SimulationResult{NETWORK_CONQUERED, time, this->events};
+    return true;
+  }
+  if (this->infected == 0 && this->hasInfected) {
+    this->result = SimulationResult{NETWORK_DEFENDED, time, this->events};
+    return true;
+  }
+  return false;
+}
+
+/* endWindow:
+ * Merges the partitions' logs into the order the sequential simulator
+ * would have processed their events in and replays the infection counts,
+ * stopping at the first event after which the run is over. Each log is
+ * already in that order, so this is a plain k-way merge.
+ */
+template<typename EventQueue>
+void ParallelSimulator<EventQueue>::endWindow() {
+  int numPartitions = this->partitions.size();
+  std::vector<size_t> heads(numPartitions, 0);
+  while (!this->done) {
+    Logged *best = nullptr;
+    int from = -1;
+    for (int i = 0; i < numPartitions; i++) {
+      std::vector<Logged>& log = this->partitions[i]->log;
+      if (heads[i] == log.size()) {  continue;  }
+      Logged& candidate = log[heads[i]];
+      if (best == nullptr || candidate.time < best->time ||
+          (candidate.time == best->time && tiebreaker(candidate.event, candidate.time, best->event, best->time))) {
+        best = &candidate;
+        from = i;
+      }
+    }
+    if (best == nullptr) {  break;  }
+    heads[from]++;
+
+    if (best->time > this->maxTime) {
+      this->done = true;
+      this->result = SimulationResult{TIMED_OUT, best->time, this->events};
+      break;
+    }
+    this->t = best->time;
+    this->infected += best->infected;
+    this->hasInfected = this->hasInfected || best->hit;
+    this->events++;
+    this->done = this->finished(this->t);
+  }
+  for (auto& p : this->partitions) {
+    p->log.clear();
+  }
+  if (!this->done) {  this->startWindow();  }
+}
+
+template<typename EventQueue>
+int ParallelSimulator<EventQueue>::ownerOf(const Event& e) {
+  int numPartitions = this->partitions.size();
+  switch (e.action) {
+    case NOTIFY:
+      return 0;
+    case DEPLOY_ATTACK:
+      return (e.source == -1) ? 0 : e.source % numPartitions;
+    default:
+      return e.target % numPartitions;
+  }
+}
+
+// Queues an event at home or mails it to the partition that owns it
+template<typename EventQueue>
+void ParallelSimulator<EventQueue>::send(Partition& p, Event& e, long long t) {
+  int owner = this->ownerOf(e);
+  if (owner == p.index) {
+    p.q.push(e, t);
+    return;
+  }
+  ParallelMessage *m = p.outgoing.allocate();
+  m->time = t;
+  m->event = e;
+  this->partitions[owner]->inbox.post(m);
+}
+
+template<typename EventQueue>
+void ParallelSimulator<EventQueue>::process(Partition& p, Event& e) {
+  ModelState state = this->modelState(p);
+  auto schedule = [this, &p](Event& e, long long t) {  this->send(p, e, t);  };
+  EventEffect effect = makeRules(state, schedule).process(e);
+  p.log.push_back(Logged{p.t, e, effect.infected, effect.hit});
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include "parallel.hpp"
+
+bool sameResult(const SimulationResult& a, const SimulationResult& b) {
+  return a.outcome == b.outcome && a.endTime == b.endTime && a.events == b.events;
+}
+
+// Every thread count has to end every seed exactly like the sequential
+// simulator does
+bool matchesSequential(int numComputers, int attack, int detect, const Topology *topology, int seeds) {
+  const int threadCounts[] = {1, 2, 3, 4, 8};
+  for (int seed = 0; seed < seeds; seed++) {
+    Simulator<> sequential(numComputers, attack, detect, seed);
+    sequential.setTopology(topology);
+    SimulationResult expected = sequential.simulate();
+    for (int threads : threadCounts) {
+      ParallelSimulator<> parallel(numComputers, attack, detect, threads, seed);
+      parallel.setTopology(topology);
+      if (!sameResult(parallel.simulate(), expected)) {  return false;  }
+    }
+  }
+  return true;
+}
+
+// Random sparse network with link latencies from 20 up, so the lookahead
+// is well under the usual 100
+std::string randomEdges(int n, int degree, std::mt19937& mt) {
+  std::uniform_int_distribution<int> computer(0, n - 1), latency(20, 300), ids(0, 3);
+  std::string text = std::to_string(n) + " " + std::to_string(n * degree) + "\n";
+  for (int i = 0; i < n * degree; i++) {
+    int u = computer(mt), v = computer(mt);
+    if (u == v) {  v = (u + 1) % n;  }
+    text += std::to_string(u) + " " + std::to_string(v) + " " + std::to_string(latency(mt)) + " " +
+            std::to_string(ids(mt) == 0) + "\n";
+  }
+  return text;
+}
+
+int main() {
+  // Mostly attacker wins, mostly a coin toss, and bigger
+  std::cout << "ATTACKER: " << (matchesSequential(50, 60, 20, nullptr, 20) ? "MATCHES SEQUENTIAL" : "MISMATCH") << std::endl;
+  std::cout << "CLOSE: " << (matchesSequential(300, 5, 90, nullptr, 20) ? "MATCHES SEQUENTIAL" : "MISMATCH") << std::endl;
+  std::cout << "LARGE: " << (matchesSequential(5000, 50, 50, nullptr, 3) ? "MATCHES SEQUENTIAL" : "MISMATCH") << std::endl;
+
+  std::mt19937 mt(130);
+  Topology topology;
+  topology.parse(randomEdges(400, 3, mt), TOPOLOGY_EDGES);
+  std::cout << "TOPOLOGY: " << (matchesSequential(400, 50, 50, &topology, 10) ? "MATCHES SEQUENTIAL" : "MISMATCH") << std::endl;
+
+  // One big run, to see whether the partitions pay for their windows
+  int threads = std::max<int>(std::thread::hardware_concurrency(), 2);
+  auto start = std::chrono::steady_clock::now();
+  Simulator<> sequential(400000, 50, 10, 130);
+  SimulationResult expected = sequential.simulate();
+  std::chrono::duration<double> sequentialTime = std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  ParallelSimulator<> parallel(400000, 50, 10, threads, 130);
+  SimulationResult got = parallel.simulate();
+  std::chrono::duration<double> parallelTime = std::chrono::steady_clock::now() - start;
+  std::cout << "400000 COMPUTERS, " << expected.events << " EVENTS: SEQUENTIAL " << sequentialTime.count() << "s "
+            << threads << " THREADS " << parallelTime.count() << "s, "
+            << (sameResult(got, expected) ? "MATCHES SEQUENTIAL" : "MISMATCH") << std::endl;
+}
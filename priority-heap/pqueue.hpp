@@ -2,17 +2,62 @@
 #define PQUEUE_H
 #include "heap.hpp"
 
-template<typename Contents, Tiebreaker<Contents> onTie>
-class PriorityQueue {
+/*
+ * Min priority queue over any ordering policy and priority type. Most users
+ * want the PriorityQueue alias below, which orders by a long long priority 
+ * and settles ties with a tiebreaker function. An Addressable queue returns
+ * a handle from push that can later be used to reschedule or cancel the entry.
+ * Storage comes from Alloc (see arena.hpp for a bump allocator that suits
+ * short-lived queues).
+ */
+template<typename Contents, typename Order, int Arity = 2, typename Key = long long, 
+         bool Addressable = false, typename Alloc = std::allocator<Contents>>
+class BasicPriorityQueue {
   private:
-    MinHeap<Contents, onTie> heap;
+    Heap<Contents, Order, Arity, Key, Addressable, Alloc> heap;
   public:
-    PriorityQueue() : heap() { }
-    PriorityQueue(int size) : heap(size) { }
+    BasicPriorityQueue() : heap() { }
+    BasicPriorityQueue(int size, const Alloc& alloc = Alloc()) : heap(size, alloc) { }
+    explicit BasicPriorityQueue(const Alloc& alloc) : heap(alloc) { }
+    template<typename Iterator>
+    BasicPriorityQueue(Iterator first, Iterator last, int *handlesOut = nullptr, const Alloc& alloc = Alloc()) 
+      : heap(first, last, handlesOut, alloc) { }
 
-    void push(Contents& c, long long priority) {  this->heap.push(c, priority);  }
+    int push(Contents& c, Key priority) {  return this->heap.push(c, priority);  }
+    int push(Contents&& c, Key priority) {  return this->heap.push(std::move(c), priority);  }
+    template<typename... Args>
+    int emplace(Key priority, Args&&... args) {  
+      return this->heap.emplace(priority, std::forward<Args>(args)...);  
+    }
+    template<typename Iterator>
+    void pushBatch(Iterator first, Iterator last, int *handlesOut = nullptr) {  
+      this->heap.pushBatch(first, last, handlesOut);  
+    }
     Contents popContent() {  return this->heap.pop().content;  }
-    PriorityContainer<Contents> pop() {  return this->heap.pop();  }
+    PriorityContainer<Contents, Key> pop() {  return this->heap.pop();  }
+    Key popInto(Contents& out) {  return this->heap.popInto(out);  }
+    template<typename OutputIt>
+    int popK(int k, OutputIt out) {  return this->heap.popK(k, out);  }
+    template<typename OutputIt>
+    int popUntil(Key priority, OutputIt out) {  return this->heap.popUntil(priority, out);  }
+    template<typename OutputIt>
+    int peekTopK(int k, OutputIt out) {  return this->heap.peekTopK(k, out);  }
+    Contents& top() {  return this->heap.top();  }
+    Key topPriority() {  return this->heap.topPriority();  }
     bool isEmpty() {  return this->heap.isEmpty();  }
+
+    void clear() {  this->heap.clear();  }
+    void reserve(int capacity) {  this->heap.reserve(capacity);  }
+    void shrinkToFit() {  this->heap.shrinkToFit();  }
+    void setGrowthFactor(double factor) {  this->heap.setGrowthFactor(factor);  }
+    void setShrinkOnDrain(bool shrink) {  this->heap.setShrinkOnDrain(shrink);  }
+
+    bool contains(int handle) {  return this->heap.contains(handle);  }
+    void update(int handle, Key priority) {  this->heap.update(handle, priority);  }
+    void erase(int handle) {  this->heap.erase(handle);  }
 };
+
+template<typename Contents, Tiebreaker<Contents> onTie, int Arity = 2, 
+         bool Addressable = false, typename Alloc = std::allocator<Contents>>
+using PriorityQueue = BasicPriorityQueue<Contents, MinOrder<Contents, long long, onTie>, Arity, long long, Addressable, Alloc>;
 #endif
@@ -1,19 +1,76 @@
 #include "pqueue.hpp"
+#include "arena.hpp"
 #include <iostream>
+#include <vector>
 
-bool tiebreaker(std::string& x1, int p1, std::string& x2, int p2) {
+bool tiebreaker(std::string& x1, long long p1, std::string& x2, long long p2) {
   return x1 > x2;
 }
 
+// Payload without a default constructor, which the queue never needs
+struct Job {
+  Job(int id) : id(id) { }
+  int id;
+};
+
+bool jobTiebreaker(Job& x1, long long, Job& x2, long long) {
+  return x1.id < x2.id;
+}
+
 int main() {
   PriorityQueue<std::string, tiebreaker> q;
   std::string attack = "ATTACK";
   std::string repair = "REPAIR";
   q.push(attack, 5);
   q.push(repair, 10);
+  q.push(std::string("DETECT"), 7);
+  q.emplace(3, 6, '#');
   PriorityContainer<std::string> next;
   while (!q.isEmpty()) {
     next = q.pop();
     std::cout << "TIME: " << next.priority << " ACTION: " + next.content << std::endl;
   }
+
+  q.emplace(2, "NOTIFY");
+  q.emplace(1, "DEPLOY");
+  std::string action;
+  while (!q.isEmpty()) {
+    std::cout << "NEXT: " << q.top() << " AT " << q.topPriority();
+    long long time = q.popInto(action);
+    std::cout << " POPPED: " << action << " AT " << time << std::endl;
+  }
+
+  // Entries loaded in a batch get handles just like pushed ones
+  PriorityQueue<std::string, tiebreaker, 2, true> addressable;
+  std::vector<PriorityContainer<std::string>> loaded = {
+    PriorityContainer<std::string>("SCAN", 4), PriorityContainer<std::string>("PATCH", 8),
+    PriorityContainer<std::string>("REBOOT", 9)
+  };
+  int handles[3];
+  addressable.pushBatch(loaded.begin(), loaded.end(), handles);
+  addressable.update(handles[2], 1);
+  addressable.erase(handles[0]);
+  while (!addressable.isEmpty()) {
+    next = addressable.pop();
+    std::cout << "BATCHED: " << next.content << " AT " << next.priority << std::endl;
+  }
+
+  Arena arena;
+  ArenaAllocator<Job> allocator(arena);
+  PriorityQueue<Job, jobTiebreaker, 4, false, ArenaAllocator<Job>> jobs(0, allocator);
+  jobs.setShrinkOnDrain(true);
+  for (int i = 0; i < 1000; i++) {
+    jobs.emplace(i % 10, i);
+  }
+  Job job(-1);
+  long long lastTime = -1;
+  int lastId = -1;
+  bool ordered = true;
+  while (!jobs.isEmpty()) {
+    long long time = jobs.popInto(job);
+    ordered = ordered && (time > lastTime || (time == lastTime && job.id > lastId));
+    lastTime = time;
+    lastId = job.id;
+  }
+  std::cout << "ARENA JOBS: " << (ordered ? "ORDERED" : "OUT OF ORDER") << std::endl;
 }
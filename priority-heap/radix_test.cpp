@@ -0,0 +1,49 @@
+#include "radix.hpp"
+#include "pqueue.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+bool tiebreaker(int& x1, long long, int& x2, long long) {
+  return x1 < x2;
+}
+
+// Runs the "hold" workload (pop the earliest event, schedule a new one a 
+// random distance after it), which keeps the priorities monotone. Returns
+// the sum of everything popped so two queues can be compared, and reports
+// how long the holds took
+template<typename Queue>
+long long hold(Queue& q, int size, int holds, int spread, double& seconds) {
+  std::mt19937 mt(130);
+  std::uniform_int_distribution<int> increment(0, spread);
+  for (int i = 0; i < size; i++) {
+    q.push(i, increment(mt));
+  }
+  long long checksum = 0;
+  int content;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < holds; i++) {
+    long long time = q.popInto(content);
+    checksum = checksum * 31 + time * 7 + content;
+    q.push(content, time + increment(mt));
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  while (!q.isEmpty()) {
+    long long time = q.popInto(content);
+    checksum = checksum * 31 + time * 7 + content;
+  }
+  return checksum;
+}
+
+int main() {
+  int sizes[] = {10, 1000, 100000};
+  for (int size : sizes) {
+    RadixHeap<int, tiebreaker> radix;
+    MinHeap<int, tiebreaker> heap;
+    double radixSeconds, heapSeconds;
+    long long radixSum = hold(radix, size, 1000000, 1000, radixSeconds);
+    long long heapSum = hold(heap, size, 1000000, 1000, heapSeconds);
+    std::cout << "SIZE " << size << ": " << (radixSum == heapSum ? "MATCHES HEAP" : "MISMATCH")
+              << " RADIX " << radixSeconds << "s MINHEAP " << heapSeconds << "s" << std::endl;
+  }
+}
@@ -1,329 +1,196 @@
-#include "pqueue.hpp"
-#include <random>
+#include "simulator.hpp"
+#include "parallel.hpp"
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <stdlib.h>
+#include <unistd.h>
+#include <vector>
 
+const char *OUTCOME_NAMES[] = {"queue_empty", "attacker_wins", "sysadmin_wins", "draw", "paused"};
 
-// Since subclassing seems a little overkill for the task, we will 
-// just use a struct with an action property that hold the type of 
-// action it represents
-enum ACTION {EXECUTE_ATTACK=4, DEPLOY_ATTACK=3, EXECUTE_REPAIR=2, DEPLOY_REPAIR=1, NOTIFY=0};
-struct Event {
-  ACTION action;
-  int source;
-  int target;
-};
-
-// Sysadmin struct to simply track when its next available fix can be
-// performed
-struct SysAdmin {
-  // ****, we're dealing with a sysadmin (https://xkcd.com/705/)
-  int nextFixTime;
-};
-
-// Tiebreaker function for the MinHeap
-bool tiebreaker(Event& x1, int p1, Event& x2, int p2) {
-  return x1.action > x2.action;
-}
-
-// We'll communicate the end conditions with an enum. Note that the empty
-// queue condition is not caught since we want the program to crash if the 
-// queue is somehow emptied
-enum END_CONDITIONS {QUEUE_EMPTY, NETWORK_CONQUERED, NETWORK_DEFENDED, TIMED_OUT};
-
-/*
- * Our simulator object. Contains all of the elements of our simulation. 
- * Performs a simple fetch-execute cycle of all of the elements in the 
- * priority queue. 
+/* forkAndReport:
+ * Runs the simulation up to forkAt, then carries a copy of it on to the end
+ * once for each detect probability in whatIf, printing how each one ended.
+ * The shared prefix is only simulated once and is the only part traced.
  */
-class Simulator {
-  private:
-    // Time tracking
-    int t = 0;
-    long long maxTime = 8640000000;
-
-    // Simulation characteristics from the user
-    int numComputers;
-    int attackProbability;
-    int detectProbability;
-
-    // Actual body of the simulation state
-    PriorityQueue<Event, tiebreaker> q;
-    SysAdmin sysadmin;
-    bool *computers;
-
-    // Boolean for making sure we don't end the simulation before
-    // the attacker has managed to successfully attack a computer
-    bool hasInfected = false;
-
-    // Fancy STL tools for random number generation
-    std::mt19937 mt;
-    std::uniform_int_distribution<int> prob_distribution{0, 100};
-    std::uniform_int_distribution<int> comp_distribution;
-    
-    // Fetch-Execute cycle
-    Event fetch(); 
-    void process(Event& e);
-
-    int computersInfected();
-
-    // Helper methods for scheduling events  
-    void scheduleDeployAttack(int source);
-    void scheduleExecuteAttack(int source, int target);
-    void scheduleDeployRepair(int target);
-    void scheduleExecuteRepair(int target);
-    void scheduleNotify(int source);
-
-    // Methods for executing the events in the queue
-    void processDeployAttack(Event& e);
-    void processExecuteAttack(Event& e);
-    void processDeployRepair(Event& e);
-    void processExecuteRepair(Event& e);
-    void processNotify(Event& e);
-
-    // Methods for all of the randomness in the simulation
-    bool attempt(int prob) {  return this->prob_distribution(this->mt) < prob;  }
-    int randomComputer(int computer) {  
-      int randComp = this->comp_distribution(this->mt);  
-      return (randComp != computer) ? randComp : this->randomComputer(computer);
-    }
-    bool detectedByIDS(int source, int target);
-  public:
-
-    // Constructors and Deconstructors
-    Simulator(int numComputers, int attackProbability, int detectProbability);
-    Simulator operator=(Simulator& rhs);
-    Simulator(Simulator& rhs);
-    ~Simulator() {  delete[] computers;  }
-
-    void run();
-};
-
-// Constructor
-Simulator::Simulator(int numComputers, int attackProbability, int detectProbability)
-  : numComputers(numComputers), attackProbability(attackProbability), detectProbability(detectProbability), comp_distribution{0, numComputers - 1} {
-  this->computers = new bool[this->numComputers];
-  for (int i = 0; i < this->numComputers; i++) {
-    this->computers[i] = false;
+template<typename EventQueue>
+void forkAndReport(Simulator<EventQueue>& simulator, int attackProbability, long long forkAt, 
+                   const std::vector<int>& whatIf, TraceWriter *trace) {
+  SimulationResult prefix = simulator.simulateUntil(forkAt);
+  trace->flush();
+  if (prefix.outcome != PAUSED) {
+    std::cout << "The run ended before " << forkAt << ": " << OUTCOME_NAMES[prefix.outcome]
+              << " at " << prefix.endTime << std::endl;
+    return;
+  }
+  std::cout << "detect,outcome,end_time,events" << std::endl;
+  for (int detect : whatIf) {
+    Simulator<EventQueue> fork(simulator);
+    fork.setTrace(nullptr);
+    fork.setProbabilities(attackProbability, detect);
+    SimulationResult r = fork.simulate();
+    std::cout << detect << "," << OUTCOME_NAMES[r.outcome] << "," << r.endTime << "," << r.events << std::endl;
   }
-  auto seed = time(0);
-  this->mt = std::mt19937(seed);
-  this->comp_distribution = std::uniform_int_distribution<int>(0, numComputers - 1);
 }
 
-// Copy constructor
-Simulator::Simulator(Simulator& s) : Simulator(s.numComputers, s.attackProbability, s.detectProbability) {
-  this->t = s.t;
-  this->maxTime = s.maxTime;
-  this->numComputers = s.numComputers;
-  this->attackProbability = s.attackProbability;
-  this->detectProbability = s.detectProbability;
-  this->q = s.q;
-  this->sysadmin = s.sysadmin;
-  delete[] this->computers;
-  this->computers = new bool[this->numComputers];
-  for (int i = 0; i < this->numComputers; i++) {
-    this->computers[i] = s.computers[i];
+template<typename EventQueue>
+void simulate(int numComputers, int attackProbability, int detectProbability, unsigned int seed, TraceWriter *trace, 
+              const Topology *topology, long long forkAt, const std::vector<int>& whatIf, int threads) {
+  if (threads > 0) {
+    ParallelSimulator<EventQueue> parallel(numComputers, attackProbability, detectProbability, threads, seed);
+    parallel.setTopology(topology);
+    parallel.run();
+    return;
+  }
+  Simulator<EventQueue> simulator(numComputers, attackProbability, detectProbability, seed);
+  simulator.setTrace(trace);
+  simulator.setTopology(topology);
+  if (whatIf.empty()) {
+    simulator.run();
+  } else {
+    forkAndReport(simulator, attackProbability, forkAt, whatIf, trace);
   }
-  this->hasInfected = s.hasInfected;
-  this->mt = s.mt;
-  this->prob_distribution = s.prob_distribution;
-  this->comp_distribution = s.comp_distribution;
 }
 
-// Overloaded assignment operator. While admittedly not the most robust
-// implementation, this program is not intended to function in an environment 
-// in which it is absolutely critical that it performs
-Simulator Simulator::operator=(Simulator& s) {
-  delete[] this->computers;
-  new (this) Simulator(s);
-  return *this;
+// Parses a comma separated list of probabilities, e.g. "10,50,90"
+bool parseProbabilities(const char *text, std::vector<int>& out) {
+  out.clear();
+  while (*text != '\0') {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value < 0 || value > 100) {  return false;  }
+    out.push_back(static_cast<int>(value));
+    text = end;
+    if (*text == ',') {  text++;  }
+    else if (*text != '\0') {  return false;  }
+  }
+  return !out.empty();
 }
 
-// Starts the simulation, runs the fetch-execute cycle, and 
-// monitors the simulation for the ending condition
-void Simulator::run() {
-  std::cout << "STARTING SIMULATION" << std::endl;
-  this->scheduleDeployAttack(-1);
-  try {
-    Event fetched;
-    while (true) {
-      fetched = this->fetch();
-      this->process(fetched);
-    }
-  } catch (END_CONDITIONS e) {
-    switch (e) {
-      case NETWORK_CONQUERED:
-        std::cout << "Attacker wins" << std::endl;
-        break;
-      case NETWORK_DEFENDED:
-        std::cout << "Sysadmin wins" << std::endl
-                  << std::endl << "-------------------------------------------------------------------" << std::endl << std::endl 
-                  << "****, we're dealing with a sysadmin (https://xkcd.com/705/)" << std::endl
-                  << std::endl << "-------------------------------------------------------------------" << std::endl << std::endl;
-        break;
-      case TIMED_OUT:
-        std::cout << "Draw" << std::endl;
-        break;
-      case QUEUE_EMPTY:
-        std::cerr << "The queue is empty. This is not intended. Simulation terminating." << std::endl;
+int main(int argc, char** argv) {
+  const char *queue = nullptr;
+  const char *traceMode = "text";
+  const char *traceFile = nullptr;
+  const char *topologyFile = nullptr;
+  const char *topologyFormat = "edges";
+  long long forkAt = -1;
+  int threads = 0;
+  unsigned int seed = static_cast<unsigned int>(time(0));
+  std::vector<int> whatIf;
+  char *positional[3];
+  int numPositional = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--queue=", 8) == 0) {
+      queue = argv[i] + 8;
+    } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+      traceMode = argv[i] + 8;
+    } else if (strncmp(argv[i], "--trace-file=", 13) == 0) {
+      traceFile = argv[i] + 13;
+    } else if (strncmp(argv[i], "--topology=", 11) == 0) {
+      topologyFile = argv[i] + 11;
+    } else if (strncmp(argv[i], "--topology-format=", 18) == 0) {
+      topologyFormat = argv[i] + 18;
+    } else if (strncmp(argv[i], "--fork-at=", 10) == 0) {
+      forkAt = atoll(argv[i] + 10);
+    } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+      threads = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+      seed = static_cast<unsigned int>(strtoul(argv[i] + 7, nullptr, 10));
+    } else if (strncmp(argv[i], "--what-if=", 10) == 0) {
+      if (!parseProbabilities(argv[i] + 10, whatIf)) {
+        std::cerr << "Bad what-if list: " << argv[i] + 10 << std::endl;
         exit(1);
+      }
+    } else if (numPositional < 3) {
+      positional[numPositional++] = argv[i];
+    } else {
+      numPositional++;
     }
   }
-}
-
-// The fetch part of the fetch-execute cycle
-Event Simulator::fetch() {
-  if (q.isEmpty()) throw QUEUE_EMPTY; 
-  if (this->computersInfected() > (numComputers + 1) / 2) throw NETWORK_CONQUERED;
-  if (this->computersInfected() == 0 && this->hasInfected) throw NETWORK_DEFENDED;
-
-  auto next = q.pop();
-  this->t = next.priority;
-  if (this->t > maxTime) throw TIMED_OUT;
-  
-  return next.content;
-}
-
-// Convenient helper function for counting the infected computers
-// for determining if end conditions have been reached
-int Simulator::computersInfected() {
-  int infected = 0;
-  for (int i = 0; i < this->numComputers; i++) {
-    if (this->computers[i] == true) {  infected++;  }
+  // The topology decides how many computers there are
+  int expectedPositional = (topologyFile == nullptr) ? 3 : 2;
+  if (numPositional != expectedPositional || (forkAt < 0) != whatIf.empty()) {
+    std::cout << "Usage: simulator <num_computers> <percent_success> <percent_detect> [--queue=heap|calendar|radix|pairing]" << std::endl
+              << "                 [--trace=quiet|text|binary] [--trace-file=<path>] [--seed=<n>]" << std::endl
+              << "                 [--fork-at=<time> --what-if=<percent_detect>,...] [--threads=<n> --trace=quiet]" << std::endl
+              << "       simulator <percent_success> <percent_detect> --topology=<path> [--topology-format=edges|matrix] ..." << std::endl;
+    exit(1);
   }
-  return infected;
-}
 
-// The execute part of the fetch-execute cycle
-void Simulator::process(Event& e) {
-  switch (e.action) {
-    case EXECUTE_ATTACK:
-      this->processExecuteAttack(e);
-      break;
-    case DEPLOY_ATTACK:
-      this->processDeployAttack(e);
-      break;
-    case EXECUTE_REPAIR:
-      this->processExecuteRepair(e);
-      break;
-    case DEPLOY_REPAIR:
-      this->processDeployRepair(e);
-      break;
-    case NOTIFY:
-      this->processNotify(e);
-      break;
+  Topology topology;
+  if (topologyFile != nullptr) {
+    TOPOLOGY_FORMAT format;
+    if (strcmp(topologyFormat, "edges") == 0) {
+      format = TOPOLOGY_EDGES;
+    } else if (strcmp(topologyFormat, "matrix") == 0) {
+      format = TOPOLOGY_MATRIX;
+    } else {
+      std::cerr << "Unknown topology format: " << topologyFormat << std::endl;
+      exit(1);
+    }
+    if (!topology.load(topologyFile, format) || topology.getSize() < 2) {
+      std::cerr << "Could not load a topology from " << topologyFile << std::endl;
+      exit(1);
+    }
   }
-}
 
-// Helper methods for scheduling events in the priority queue. Also
-// handle printing the output from the creation of the events.
-void Simulator::scheduleNotify(int source) {
-  if (source != -1) {
-    Event e;
-    e.action = NOTIFY;
-    e.source = source;
-    int t = this->t + 100;
-    this->q.push(e, this->t);
-    std::cout << "Notify(" << t << ", " << e.source << ")" << std::endl;
+  TRACE_MODE mode;
+  if (strcmp(traceMode, "quiet") == 0) {
+    mode = TRACE_QUIET;
+  } else if (strcmp(traceMode, "text") == 0) {
+    mode = TRACE_TEXT;
+  } else if (strcmp(traceMode, "binary") == 0) {
+    mode = TRACE_BINARY;
+  } else {
+    std::cerr << "Unknown trace mode: " << traceMode << std::endl;
+    exit(1);
   }
-}
-
-void Simulator::scheduleDeployAttack(int source) {
-  Event e;
-  e.action = DEPLOY_ATTACK;
-  e.source = source;
-  e.target = this->randomComputer(e.source);
-  int t = this->t + 1000;
-  this->q.push(e, t);
-  std::cout << "Deploy_Attack(" << t << ", " << e.source << ", " << e.target << ")" << std::endl;
-}
-
-void Simulator::scheduleExecuteAttack(int source, int target) {
-  Event e;
-  e.action = EXECUTE_ATTACK;
-  e.source = source;
-  e.target = target;
-  int t = this->t + 100;
-  this->q.push(e, this->t + 100);
-  std::cout << "Execute_Attack(" << t << ", " << e.source << ", " << e.target << ")" << std::endl;
-}
-
-void Simulator::scheduleDeployRepair(int target) {
-  Event e;
-  e.action = DEPLOY_REPAIR;
-  e.target = target;
-  this->sysadmin.nextFixTime += 10000;
-  int t = this->sysadmin.nextFixTime;
-  this->q.push(e, t);
-  std::cout << "Deploy_Repair(" << t << ", " << e.target << ")" << std::endl;
-}
-
-void Simulator::scheduleExecuteRepair(int target) {
-  Event e;
-  e.action = EXECUTE_REPAIR;
-  e.target = target;
-  int t = this->t + 100;
-  this->q.push(e, this->t + 100);
-  std::cout << "Execute_Repair(" << t << ", " << e.target << ")" << std::endl;
-}
-
-
-
-// The processor method to handle the execution of the events
-// in the priority queue
-void Simulator::processDeployAttack(Event& e) {
-  if (e.source == -1 || this->computers[e.source]) {
-    this->scheduleExecuteAttack(e.source, e.target);
-    this->scheduleDeployAttack(e.source);
+  // The outcome goes to stdout as well, so a binary trace needs its own file
+  if (mode == TRACE_BINARY && traceFile == nullptr) {
+    std::cerr << "Binary traces have to go to a --trace-file" << std::endl;
+    exit(1);
   }
-}
-
-void Simulator::processExecuteAttack(Event& e) {
-  if (this->attempt(this->attackProbability)) {
-    this->hasInfected = true;
-    if (!this->computers[e.target]) {
-      this->computers[e.target] = true;
-      this->scheduleDeployAttack(e.target);
-      if (this->detectedByIDS(e.source, e.target)) {
-        this->scheduleNotify(e.source);
-        this->scheduleNotify(e.target);
-      }
+  // Parallel runs neither trace nor fork
+  if (threads > 0 && (mode != TRACE_QUIET || !whatIf.empty())) {
+    std::cerr << "Parallel runs need --trace=quiet and can't fork" << std::endl;
+    exit(1);
+  }
+  int numComputers = (topologyFile == nullptr) ? atoi(positional[0]) : topology.getSize();
+  int attackProbability = atoi(positional[expectedPositional - 2]);
+  int detectProbability = atoi(positional[expectedPositional - 1]);
+  if (numComputers < 2) {
+    std::cerr << "Networks need at least two computers" << std::endl;
+    exit(1);
+  }
+  int fd = STDOUT_FILENO;
+  if (traceFile != nullptr) {
+    fd = open(traceFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      std::cerr << "Could not open " << traceFile << std::endl;
+      exit(1);
     }
   }
-}
-
-void Simulator::processDeployRepair(Event &e) {
-  this->scheduleExecuteRepair(e.target);
-}
 
-void Simulator::processExecuteRepair(Event &e) {
-  this->computers[e.target] = false;
-}
-
-void Simulator::processNotify(Event &e) {
-  this->scheduleDeployRepair(e.source);
-}
-
-
-// Method to determine if an attack was successfully determine by the IDS
-bool Simulator::detectedByIDS(int source, int target) {
-  if (source == -1) {
-    return this->attempt(this->detectProbability);
+  const Topology *layout = (topologyFile == nullptr) ? nullptr : &topology;
+  TraceWriter trace(mode, fd);
+  if (queue == nullptr) {
+    simulate<SIM_EVENT_QUEUE>(numComputers, attackProbability, detectProbability, seed, &trace, layout, forkAt, whatIf, threads);
+  } else if (strcmp(queue, "heap") == 0) {
+    simulate<HeapEventQueue>(numComputers, attackProbability, detectProbability, seed, &trace, layout, forkAt, whatIf, threads);
+  } else if (strcmp(queue, "calendar") == 0) {
+    simulate<CalendarEventQueue>(numComputers, attackProbability, detectProbability, seed, &trace, layout, forkAt, whatIf, threads);
+  } else if (strcmp(queue, "radix") == 0) {
+    simulate<RadixEventQueue>(numComputers, attackProbability, detectProbability, seed, &trace, layout, forkAt, whatIf, threads);
+  } else if (strcmp(queue, "pairing") == 0) {
+    simulate<PairingEventQueue>(numComputers, attackProbability, detectProbability, seed, &trace, layout, forkAt, whatIf, threads);
   } else {
-    bool sourceSide = (source >= (this->numComputers / 2));
-    bool targetSide = (target >= (this->numComputers / 2));
-    bool crossesIDS = (sourceSide != targetSide);
-    return crossesIDS && this->attempt(this->detectProbability);
+    std::cerr << "Unknown queue: " << queue << std::endl;
+    exit(1);
   }
-}
-
-        
-int main(int argc, char** argv) {
-  if (argc != 4) {
-    std::cout << "Usage: simulator <num_computers> <percent_success> <percent_detect>" << std::endl;
+  if (!trace.flush()) {
+    std::cerr << "Could not write the trace: " << strerror(trace.getError()) << std::endl;
     exit(1);
   }
-  Simulator simulator(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]));
-  simulator.run();
+  if (traceFile != nullptr) {  close(fd);  }
 }
@@ -0,0 +1,651 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+#include "pqueue.hpp"
+#include "calendar.hpp"
+#include "radix.hpp"
+#include "pairing.hpp"
+#include "network.hpp"
+#include "topology.hpp"
+#include "trace.hpp"
+#include <climits>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <iostream>
+#include <stdlib.h>
+
+
+// Since subclassing seems a little overkill for the task, we will 
+// just use a struct with an action property that hold the type of 
+// action it represents
+enum ACTION {EXECUTE_ATTACK=4, DEPLOY_ATTACK=3, EXECUTE_REPAIR=2, DEPLOY_REPAIR=1, NOTIFY=0};
+const int NUM_ACTIONS = 5;
+const char * const ACTION_NAMES[NUM_ACTIONS] = {"NOTIFY", "DEPLOY_REPAIR", "EXECUTE_REPAIR", "DEPLOY_ATTACK", "EXECUTE_ATTACK"};
+struct Event {
+  ACTION action;
+  int source;
+  int target;
+  // Topology link an attack travels over, -1 if it isn't running on one
+  int link;
+  // Where the event comes from, see EventStream
+  unsigned long long id;
+};
+
+// Sysadmin struct to simply track when its next available fix can be
+// performed
+struct SysAdmin {
+  // ****, we're dealing with a sysadmin (https://xkcd.com/705/)
+  long long nextFixTime = 0;
+};
+
+// Writes the trace line for an event scheduled at time t into out, which
+// needs room for TRACE_LINE_BYTES, and returns its length. Used by the 
+// simulator for text traces and by the decoder for binary ones
+const int TRACE_LINE_BYTES = 80;
+inline int formatEvent(char *out, long long t, const Event& e) {
+  switch (e.action) {
+    case NOTIFY:
+      return snprintf(out, TRACE_LINE_BYTES, "Notify(%lld, %d)\n", t, e.source);
+    case DEPLOY_ATTACK:
+      return snprintf(out, TRACE_LINE_BYTES, "Deploy_Attack(%lld, %d, %d)\n", t, e.source, e.target);
+    case EXECUTE_ATTACK:
+      return snprintf(out, TRACE_LINE_BYTES, "Execute_Attack(%lld, %d, %d)\n", t, e.source, e.target);
+    case DEPLOY_REPAIR:
+      return snprintf(out, TRACE_LINE_BYTES, "Deploy_Repair(%lld, %d)\n", t, e.target);
+    case EXECUTE_REPAIR:
+      return snprintf(out, TRACE_LINE_BYTES, "Execute_Repair(%lld, %d)\n", t, e.target);
+  }
+  return 0;
+}
+
+// Tiebreaker function for the MinHeap. Events due at the same time go by
+// action, and then by target, source and id, so every queue processes
+// them in exactly the same order
+inline bool tiebreaker(Event& x1, long long, Event& x2, long long) {
+  if (x1.action != x2.action) {  return x1.action > x2.action;  }
+  if (x1.target != x2.target) {  return x1.target < x2.target;  }
+  if (x1.source != x2.source) {  return x1.source < x2.source;  }
+  return x1.id < x2.id;
+}
+
+// Finalizer of splitmix64, scrambles all 64 bits into all the others.
+// Also what sweep derives its replica seeds with
+inline unsigned long long mixBits(unsigned long long x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/*
+ * Counter based random numbers for the simulation. An event's draws come
+ * from a stream keyed by the seed and the event's id, and the ids of the
+ * events it schedules come from its own id and the order it schedules
+ * them in. So what an event draws depends on its ancestry alone, not on
+ * whatever else happened to be processed before it. A run doesn't
+ * depend on how its queue happens to order things internally, and events
+ * could be processed in any order that respects causality and still
+ * make the same draws.
+ */
+class EventStream {
+  private:
+    static const unsigned long long GOLDEN = 0x9e3779b97f4a7c15ULL;
+    unsigned long long key = 0;
+    unsigned long long id = 0;
+    unsigned long long draws = 0;
+    unsigned long long children = 0;
+  public:
+    // Starts the stream of the event with the given id. Id 0 is the start
+    // of the run, before any event
+    void start(unsigned long long seed, unsigned long long id) {
+      this->key = mixBits(mixBits(seed) ^ id);
+      this->id = id;
+      this->draws = 0;
+      this->children = 0;
+    }
+    unsigned long long next() {  return mixBits(this->key + ++this->draws * GOLDEN);  }
+    // Uniform in [0, bound)
+    int below(int bound) {  
+      return static_cast<int>(((this->next() >> 32) * static_cast<unsigned long long>(bound)) >> 32);  
+    }
+    // Id for the next event scheduled by this one
+    unsigned long long nextChild() {  return mixBits(this->id + ++this->children * GOLDEN);  }
+};
+
+// We'll communicate the end conditions with an enum. Note that the empty
+// queue condition is not caught since we want the program to crash if the 
+// queue is somehow emptied. PAUSED isn't an end at all, it is what 
+// simulateUntil hands back when it stops before the run is over
+enum END_CONDITIONS {QUEUE_EMPTY, NETWORK_CONQUERED, NETWORK_DEFENDED, TIMED_OUT, PAUSED};
+
+// How a single run ended, when, and how many events it took to get there
+struct SimulationResult {
+  END_CONDITIONS outcome;
+  long long endTime;
+  long long events;
+};
+
+// Prints how a run ended
+inline void printOutcome(END_CONDITIONS outcome) {
+  switch (outcome) {
+    case NETWORK_CONQUERED:
+      std::cout << "Attacker wins" << std::endl;
+      break;
+    case NETWORK_DEFENDED:
+      std::cout << "Sysadmin wins" << std::endl
+                << std::endl << "-------------------------------------------------------------------" << std::endl << std::endl 
+                << "****, we're dealing with a sysadmin (https://xkcd.com/705/)" << std::endl
+                << std::endl << "-------------------------------------------------------------------" << std::endl << std::endl;
+      break;
+    case TIMED_OUT:
+      std::cout << "Draw" << std::endl;
+      break;
+    case PAUSED:
+      break;
+    case QUEUE_EMPTY:
+      std::cerr << "The queue is empty. This is not intended. Simulation terminating." << std::endl;
+      exit(1);
+  }
+}
+
+// The event queues the simulator can run on. Any type with the push/popInto/
+// isEmpty interface of PriorityQueue works. The default can be picked at 
+// compile time with -DSIM_EVENT_QUEUE=CalendarEventQueue. Events are never
+// scheduled in the past, so the monotone RadixHeap works too, and so does
+// the meldable PairingHeap
+typedef PriorityQueue<Event, tiebreaker> HeapEventQueue;
+typedef CalendarQueue<Event, tiebreaker> CalendarEventQueue;
+typedef RadixHeap<Event, tiebreaker> RadixEventQueue;
+typedef PairingHeap<Event, tiebreaker> PairingEventQueue;
+#ifndef SIM_EVENT_QUEUE
+#define SIM_EVENT_QUEUE HeapEventQueue
+#endif
+
+/*
+ * Everything the rules of the simulation read or change while an event is
+ * processed. Each engine fills one in with its own clock, network and
+ * random stream: Simulator with its whole network, a partition of
+ * ParallelSimulator with the part it owns. Only the events that schedule
+ * repairs touch the sysadmin, so whoever never processes them can leave
+ * it null.
+ */
+struct ModelState {
+  long long t;
+  unsigned int seed;
+  int numComputers;
+  int attackProbability;
+  int detectProbability;
+  const Topology *topology;
+  NetworkState *network;
+  SysAdmin *sysadmin;
+  EventStream *stream;
+};
+
+// What processing an event did to the infection counts: a computer
+// infected (+1) or repaired (-1), and whether an attack got through at
+// all, which the end conditions care about even when it changed nothing
+struct EventEffect {
+  int infected;
+  bool hit;
+};
+
+/*
+ * The rules of the simulation: what each kind of event does when it is
+ * processed and which events it schedules, when. Both engines go through
+ * here, so they can't drift apart. New events go to schedule(e, t), which
+ * is the queue and the trace for Simulator and the partition's queue or
+ * another partition's mailbox for ParallelSimulator.
+ */
+template<typename Schedule>
+class EventRules {
+  private:
+    ModelState& s;
+    Schedule& schedule;
+
+    bool attempt(int prob) {  return this->s.stream->below(101) < prob;  }
+    // Any computer but the given one
+    int randomComputer(int computer) {  
+      if (computer == -1) {  return this->s.stream->below(this->s.numComputers);  }
+      int randComp = this->s.stream->below(this->s.numComputers - 1);
+      return (randComp < computer) ? randComp : randComp + 1;
+    }
+    int randomLink(int degree) {  return this->s.stream->below(degree);  }
+    bool detectedByIDS(Event& e);
+
+    void scheduleNotify(int source);
+    void scheduleExecuteAttack(int source, int target, int link);
+    void scheduleDeployRepair(int target);
+    void scheduleExecuteRepair(int target);
+
+    void processDeployAttack(Event& e);
+    void processExecuteAttack(Event& e, EventEffect& effect);
+    void processExecuteRepair(Event& e, EventEffect& effect);
+  public:
+    EventRules(ModelState& s, Schedule& schedule) : s(s), schedule(schedule) { }
+
+    // Schedules the first attack, from outside the network, at the start
+    // of a run
+    void start() {
+      this->s.stream->start(this->s.seed, 0);
+      this->scheduleDeployAttack(-1);
+    }
+    void scheduleDeployAttack(int source);
+    EventEffect process(Event& e);
+};
+
+template<typename Schedule>
+EventRules<Schedule> makeRules(ModelState& s, Schedule& schedule) {
+  return EventRules<Schedule>(s, schedule);
+}
+
+template<typename Schedule>
+EventEffect EventRules<Schedule>::process(Event& e) {
+  EventEffect effect{0, false};
+  this->s.stream->start(this->s.seed, e.id);
+  switch (e.action) {
+    case EXECUTE_ATTACK:
+      this->processExecuteAttack(e, effect);
+      break;
+    case DEPLOY_ATTACK:
+      this->processDeployAttack(e);
+      break;
+    case EXECUTE_REPAIR:
+      this->processExecuteRepair(e, effect);
+      break;
+    case DEPLOY_REPAIR:
+      this->scheduleExecuteRepair(e.target);
+      break;
+    case NOTIFY:
+      this->scheduleDeployRepair(e.source);
+      break;
+  }
+  return effect;
+}
+
+// Helper methods for scheduling events. Whoever is handed the events
+// takes care of tracing them
+template<typename Schedule>
+void EventRules<Schedule>::scheduleNotify(int source) {
+  if (source != -1) {
+    Event e{};
+    e.action = NOTIFY;
+    e.source = source;
+    e.id = this->s.stream->nextChild();
+    this->schedule(e, this->s.t + 100);
+  }
+}
+
+template<typename Schedule>
+void EventRules<Schedule>::scheduleDeployAttack(int source) {
+  Event e{};
+  e.action = DEPLOY_ATTACK;
+  e.source = source;
+  e.link = -1;
+  if (this->s.topology != nullptr && source != -1) {
+    // Only neighbors can be attacked, and a computer without any can't 
+    // spread the infection at all
+    int degree = this->s.topology->getDegree(source);
+    if (degree == 0) {  return;  }
+    e.link = this->s.topology->getLink(source, this->randomLink(degree));
+    e.target = this->s.topology->getNeighbor(e.link);
+  } else {
+    e.target = this->randomComputer(e.source);
+  }
+  e.id = this->s.stream->nextChild();
+  this->schedule(e, this->s.t + 1000);
+}
+
+template<typename Schedule>
+void EventRules<Schedule>::scheduleExecuteAttack(int source, int target, int link) {
+  Event e{};
+  e.action = EXECUTE_ATTACK;
+  e.source = source;
+  e.target = target;
+  e.link = link;
+  e.id = this->s.stream->nextChild();
+  // On a topology the link weight is how long the attack takes
+  this->schedule(e, this->s.t + ((link == -1) ? 100 : this->s.topology->getWeight(link)));
+}
+
+template<typename Schedule>
+void EventRules<Schedule>::scheduleDeployRepair(int target) {
+  Event e{};
+  e.action = DEPLOY_REPAIR;
+  e.target = target;
+  e.id = this->s.stream->nextChild();
+  // The sysadmin can't start a fix before now, however idle they have been
+  SysAdmin& sysadmin = *this->s.sysadmin;
+  if (sysadmin.nextFixTime < this->s.t) {
+    sysadmin.nextFixTime = this->s.t;
+  }
+  sysadmin.nextFixTime += 10000;
+  this->schedule(e, sysadmin.nextFixTime);
+}
+
+template<typename Schedule>
+void EventRules<Schedule>::scheduleExecuteRepair(int target) {
+  Event e{};
+  e.action = EXECUTE_REPAIR;
+  e.target = target;
+  e.id = this->s.stream->nextChild();
+  this->schedule(e, this->s.t + 100);
+}
+
+// The processor methods to handle the execution of the events
+template<typename Schedule>
+void EventRules<Schedule>::processDeployAttack(Event& e) {
+  if (e.source == -1 || this->s.network->isInfected(e.source)) {
+    this->scheduleExecuteAttack(e.source, e.target, e.link);
+    this->scheduleDeployAttack(e.source);
+  }
+}
+
+template<typename Schedule>
+void EventRules<Schedule>::processExecuteAttack(Event& e, EventEffect& effect) {
+  if (this->attempt(this->s.attackProbability)) {
+    effect.hit = true;
+    if (this->s.network->infect(e.target)) {
+      effect.infected = 1;
+      this->scheduleDeployAttack(e.target);
+      if (this->detectedByIDS(e)) {
+        this->scheduleNotify(e.source);
+        this->scheduleNotify(e.target);
+      }
+    }
+  }
+}
+
+template<typename Schedule>
+void EventRules<Schedule>::processExecuteRepair(Event& e, EventEffect& effect) {
+  if (this->s.network->repair(e.target)) {  effect.infected = -1;  }
+}
+
+// Method to determine if an attack was successfully determine by the IDS
+template<typename Schedule>
+bool EventRules<Schedule>::detectedByIDS(Event& e) {
+  if (e.source == -1) {
+    return this->attempt(this->s.detectProbability);
+  } else if (e.link != -1) {
+    return this->s.topology->isMonitored(e.link) && this->attempt(this->s.detectProbability);
+  } else {
+    bool crossesIDS = (this->s.network->sideOf(e.source) != this->s.network->sideOf(e.target));
+    return crossesIDS && this->attempt(this->s.detectProbability);
+  }
+}
+
+/*
+ * Our simulator object. Contains all of the elements of our simulation. 
+ * Performs a simple fetch-execute cycle of all of the elements in the 
+ * priority queue. 
+ */
+template<typename EventQueue = SIM_EVENT_QUEUE>
+class Simulator {
+  private:
+    // Time tracking
+    long long t = 0;
+    long long maxTime = 8640000000;
+
+    // Simulation characteristics from the user
+    int numComputers;
+    int attackProbability;
+    int detectProbability;
+
+    // Where every scheduled event gets written, if anywhere
+    TraceWriter *trace = nullptr;
+
+    // Actual body of the simulation state. The network keeps live counts 
+    // of its infected computers so the end conditions are constant time
+    EventQueue q;
+    SysAdmin sysadmin;
+    NetworkState network;
+
+    // Who can attack whom, how long it takes and where the IDSs sit. 
+    // Without one every computer can reach every other one in 100 and
+    // the IDS sits between the two halves of the network
+    const Topology *topology = nullptr;
+
+    // Boolean for making sure we don't end the simulation before
+    // the attacker has managed to successfully attack a computer
+    bool hasInfected = false;
+
+    // Whether the first attack has been scheduled, and how many events
+    // have been processed since, across pauses
+    bool started = false;
+    long long events = 0;
+
+    // Random numbers, drawn from the stream of the event being processed
+    unsigned int seed;
+    EventStream stream;
+
+#ifdef PQ_INSTRUMENT
+    // Events processed and how long their handlers took, by action
+    EventCounters eventCounters[NUM_ACTIONS];
+#endif
+    
+    // Fetch-Execute cycle
+    Event fetch(long long pauseAfter); 
+    void process(Event& e);
+
+    int computersInfected() {  return this->network.getInfected();  }
+
+    // Where the rules put the events they schedule: the queue, and the
+    // trace if there is one
+    void schedule(Event& e, long long t);
+    void traceEvent(long long t, Event& e);
+    ModelState modelState() {
+      return ModelState{this->t, this->seed, this->numComputers, this->attackProbability, this->detectProbability,
+                        this->topology, &this->network, &this->sysadmin, &this->stream};
+    }
+  public:
+
+    // Constructors and Deconstructors
+    Simulator(int numComputers, int attackProbability, int detectProbability, 
+              unsigned int seed = static_cast<unsigned int>(time(0)));
+    // A copy is a snapshot of a run in flight: the clock, the queue, the
+    // network, the sysadmin and the random number generator all come
+    // along, so a copy taken mid-run and carried on replays exactly what
+    // the original does from there. Assigning a snapshot back restores it.
+    // The trace and topology pointers are shared, so give a fork its own
+    // trace with setTrace if it shouldn't write into the original's
+    Simulator(const Simulator& rhs);
+    Simulator& operator=(const Simulator& rhs);
+#ifdef PQ_INSTRUMENT
+    ~Simulator();
+#endif
+
+    // Puts the simulator back at time 0 with new characteristics and a new
+    // seed, reusing the memory it already has
+    void reset(int numComputers, int attackProbability, int detectProbability, unsigned int seed);
+    // The simulator is quiet until it is given a trace to write to. The
+    // writer is not owned by the simulator and has to outlive the run
+    void setTrace(TraceWriter *trace) {  this->trace = trace;  }
+    // Same deal for the topology, which has to have numComputers computers
+    // and stays in place across resets
+    void setTopology(const Topology *topology) {  this->topology = topology;  }
+
+    // What-if knobs for a fork. New probabilities apply to the events
+    // processed from now on, and a new seed makes the fork's luck its own
+    void setProbabilities(int attackProbability, int detectProbability) {
+      this->attackProbability = attackProbability;
+      this->detectProbability = detectProbability;
+    }
+    void reseed(unsigned int seed) {  this->seed = seed;  }
+    long long getTime() {  return this->t;  }
+
+    // run prints the outcome, simulate just hands it back. simulateUntil
+    // stops short with PAUSED once the next event is due after time, and
+    // calling either again carries on from there
+    void run();
+    SimulationResult simulate();
+    SimulationResult simulateUntil(long long time);
+
+#ifdef PQ_INSTRUMENT
+    const EventCounters& getEventCounters(ACTION action) {  return this->eventCounters[action];  }
+#endif
+};
+
+// Constructor
+template<typename EventQueue>
+Simulator<EventQueue>::Simulator(int numComputers, int attackProbability, int detectProbability, unsigned int seed)
+  : numComputers(numComputers), attackProbability(attackProbability), detectProbability(detectProbability), 
+    network(numComputers), seed(seed) { }
+
+template<typename EventQueue>
+void Simulator<EventQueue>::reset(int numComputers, int attackProbability, int detectProbability, unsigned int seed) {
+  this->t = 0;
+  this->numComputers = numComputers;
+  this->attackProbability = attackProbability;
+  this->detectProbability = detectProbability;
+  this->q.clear();
+  this->sysadmin = SysAdmin();
+  this->network.reset(numComputers);
+  this->hasInfected = false;
+  this->started = false;
+  this->events = 0;
+  this->seed = seed;
+}
+
+// Copy constructor. Member by member, the queue included, so taking a
+// snapshot costs the pending events and the network bitset and nothing
+// more. Instrumentation counters start over so nothing is counted twice
+template<typename EventQueue>
+Simulator<EventQueue>::Simulator(const Simulator& s)
+  : t(s.t), maxTime(s.maxTime), numComputers(s.numComputers), attackProbability(s.attackProbability),
+    detectProbability(s.detectProbability), trace(s.trace), q(s.q), sysadmin(s.sysadmin), 
+    network(s.network), topology(s.topology), hasInfected(s.hasInfected), started(s.started), 
+    events(s.events), seed(s.seed), stream(s.stream) { }
+
+template<typename EventQueue>
+Simulator<EventQueue>& Simulator<EventQueue>::operator=(const Simulator& s) {
+  if (this != &s) {
+    this->t = s.t;
+    this->maxTime = s.maxTime;
+    this->numComputers = s.numComputers;
+    this->attackProbability = s.attackProbability;
+    this->detectProbability = s.detectProbability;
+    this->trace = s.trace;
+    this->q = s.q;
+    this->sysadmin = s.sysadmin;
+    this->network = s.network;
+    this->topology = s.topology;
+    this->hasInfected = s.hasInfected;
+    this->started = s.started;
+    this->events = s.events;
+    this->seed = s.seed;
+    this->stream = s.stream;
+  }
+  return *this;
+}
+
+#ifdef PQ_INSTRUMENT
+// Hands the event counts over to be dumped at exit
+template<typename EventQueue>
+Simulator<EventQueue>::~Simulator() {
+  for (int a = 0; a < NUM_ACTIONS; a++) {
+    InstrumentRegistry::get().addEvents(ACTION_NAMES[a], this->eventCounters[a]);
+  }
+}
+#endif
+
+// Starts the simulation, runs the fetch-execute cycle, and 
+// monitors the simulation for the ending condition
+template<typename EventQueue>
+void Simulator<EventQueue>::run() {
+  std::cout << "STARTING SIMULATION" << std::endl;
+  END_CONDITIONS outcome = this->simulate().outcome;
+  if (this->trace != nullptr) {  this->trace->flush();  }
+  printOutcome(outcome);
+}
+
+// Runs the fetch-execute cycle from the start until an ending condition
+template<typename EventQueue>
+SimulationResult Simulator<EventQueue>::simulate() {
+  return this->simulateUntil(LLONG_MAX);
+}
+
+// The end conditions are checked before the pause, so a run that is over
+// says so rather than pausing
+template<typename EventQueue>
+SimulationResult Simulator<EventQueue>::simulateUntil(long long time) {
+  if (!this->started) {
+    ModelState state = this->modelState();
+    auto schedule = [this](Event& e, long long t) {  this->schedule(e, t);  };
+    makeRules(state, schedule).start();
+    this->started = true;
+  }
+  try {
+    Event fetched;
+    while (true) {
+      fetched = this->fetch(time);
+      this->process(fetched);
+      this->events++;
+    }
+  } catch (END_CONDITIONS e) {
+    return SimulationResult{e, this->t, this->events};
+  }
+}
+
+// The fetch part of the fetch-execute cycle. Building with -DSIM_AUDIT
+// also checks the infection counters against the network on every event.
+// Events due after pauseAfter are left in the queue
+template<typename EventQueue>
+Event Simulator<EventQueue>::fetch(long long pauseAfter) {
+  if (q.isEmpty()) throw QUEUE_EMPTY; 
+  if (this->computersInfected() > (numComputers + 1) / 2) throw NETWORK_CONQUERED;
+  if (this->computersInfected() == 0 && this->hasInfected) throw NETWORK_DEFENDED;
+#ifdef SIM_AUDIT
+  if (!this->network.audit()) {
+    std::cerr << "Infection counters out of sync with the network at t = " << this->t << std::endl;
+    exit(1);
+  }
+#endif
+  if (pauseAfter != LLONG_MAX && q.topPriority() > pauseAfter) throw PAUSED;
+
+  Event next;
+  this->t = q.popInto(next);
+  if (this->t > maxTime) throw TIMED_OUT;
+  
+  return next;
+}
+
+// The execute part of the fetch-execute cycle
+template<typename EventQueue>
+void Simulator<EventQueue>::process(Event& e) {
+#ifdef PQ_INSTRUMENT
+  auto start = std::chrono::steady_clock::now();
+#endif
+  ModelState state = this->modelState();
+  auto schedule = [this](Event& e, long long t) {  this->schedule(e, t);  };
+  if (makeRules(state, schedule).process(e).hit) {
+    this->hasInfected = true;
+  }
+#ifdef PQ_INSTRUMENT
+  std::chrono::nanoseconds took = std::chrono::steady_clock::now() - start;
+  this->eventCounters[e.action].record(took.count());
+#endif
+}
+
+// Hands a newly scheduled event to the trace, formatted for its mode
+template<typename EventQueue>
+void Simulator<EventQueue>::traceEvent(long long t, Event& e) {
+  if (this->trace == nullptr) {  return;  }
+  switch (this->trace->getMode()) {
+    case TRACE_QUIET:
+      break;
+    case TRACE_TEXT: {
+      char line[TRACE_LINE_BYTES];
+      this->trace->write(line, formatEvent(line, t, e));
+      break;
+    }
+    case TRACE_BINARY:
+      this->trace->record(t, e.action, e.source, e.target);
+      break;
+  }
+}
+
+template<typename EventQueue>
+void Simulator<EventQueue>::schedule(Event& e, long long t) {
+  this->q.push(e, t);
+  this->traceEvent(t, e);
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include <iostream>
+#include "simulator.hpp"
+
+bool sameResult(const SimulationResult& a, const SimulationResult& b) {
+  return a.outcome == b.outcome && a.endTime == b.endTime && a.events == b.events;
+}
+
+// A run carried on from a snapshot has to end exactly like the run it
+// was taken from, however it was paused, copied or restored
+template<typename EventQueue>
+void checkSnapshots(const char *name, int numComputers, unsigned int seed) {
+  Simulator<EventQueue> whole(numComputers, 60, 40, seed);
+  SimulationResult expected = whole.simulate();
+
+  Simulator<EventQueue> original(numComputers, 60, 40, seed);
+  SimulationResult paused = original.simulateUntil(expected.endTime / 2);
+  Simulator<EventQueue> fork(original);
+  Simulator<EventQueue> snapshot(original);
+  bool forked = sameResult(fork.simulate(), expected);
+  bool carriedOn = sameResult(original.simulate(), expected);
+  original = snapshot;
+  bool restored = sameResult(original.simulate(), expected);
+
+  Simulator<EventQueue> stepped(numComputers, 60, 40, seed);
+  SimulationResult step;
+  long long time = 0;
+  do {
+    time += 5000;
+    step = stepped.simulateUntil(time);
+  } while (step.outcome == PAUSED);
+  bool steps = sameResult(step, expected);
+
+  std::cout << name << ": " << (paused.outcome == PAUSED ? "PAUSED" : "NOT PAUSED") 
+            << ", FORK " << (forked ? "MATCHES" : "MISMATCH")
+            << ", ORIGINAL " << (carriedOn ? "MATCHES" : "MISMATCH")
+            << ", RESTORED " << (restored ? "MATCHES" : "MISMATCH")
+            << ", STEPPED " << (steps ? "MATCHES" : "MISMATCH") << std::endl;
+}
+
+int main() {
+  checkSnapshots<HeapEventQueue>("HEAP", 200, 130);
+  checkSnapshots<CalendarEventQueue>("CALENDAR", 200, 131);
+  checkSnapshots<RadixEventQueue>("RADIX", 200, 132);
+  checkSnapshots<PairingEventQueue>("PAIRING", 200, 133);
+
+  // A fork with a different detect probability goes its own way while
+  // the original is left alone
+  Simulator<> whole(200, 60, 40, 130);
+  SimulationResult expected = whole.simulate();
+  Simulator<> original(200, 60, 40, 130);
+  original.simulateUntil(expected.endTime / 2);
+  Simulator<> fork(original);
+  fork.setProbabilities(60, 100);
+  SimulationResult whatIf = fork.simulate();
+  bool untouched = sameResult(original.simulate(), expected);
+  std::cout << "WHAT IF: " << (sameResult(whatIf, expected) ? "SAME AS ORIGINAL" : "DIVERGED")
+            << ", ORIGINAL " << (untouched ? "UNTOUCHED" : "CHANGED") << std::endl;
+}
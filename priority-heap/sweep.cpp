@@ -0,0 +1,213 @@
+#include "simulator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Monte Carlo driver for the simulator. Runs every combination of the
+ * given network sizes and probabilities many times with independent seeds,
+ * spread over a pool of worker threads, and prints one CSV row per
+ * combination with the outcome rates (and 95% Wilson intervals) and the
+ * distribution of the end times.
+ *
+ * Replica seeds are derived from the master seed, the combination and the
+ * replica number alone, so the results are the same for any thread count.
+ */
+
+struct Config {
+  int numComputers;
+  int attackProbability;
+  int detectProbability;
+};
+
+// Turns (master seed, config, replica) into well mixed, independent seeds
+unsigned int replicaSeed(unsigned long long master, int config, int replica) {
+  unsigned long long key = (static_cast<unsigned long long>(config) << 32) | static_cast<unsigned int>(replica);
+  return static_cast<unsigned int>(mixBits(master ^ mixBits(key + 1)) >> 32);
+}
+
+// Parses a comma separated list of integers, e.g. "10,100,1000"
+bool parseList(const char *text, std::vector<int>& out) {
+  out.clear();
+  while (*text != '\0') {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text) {  return false;  }
+    out.push_back(static_cast<int>(value));
+    text = end;
+    if (*text == ',') {  text++;  }
+    else if (*text != '\0') {  return false;  }
+  }
+  return !out.empty();
+}
+
+// Wilson score interval for a binomial proportion at 95% confidence
+void wilson(int successes, int trials, double& low, double& high) {
+  const double z = 1.96;
+  double n = trials;
+  double p = successes / n;
+  double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+  double half = z * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+  low = std::max(center - half, 0.0);
+  high = std::min(center + half, 1.0);
+}
+
+// Nearest rank percentile of an already sorted list
+long long percentile(const std::vector<long long>& sorted, double fraction) {
+  int rank = static_cast<int>(std::ceil(fraction * sorted.size()));
+  return sorted[std::max(rank, 1) - 1];
+}
+
+/* sweep:
+ * Workers pull (config, replica) tasks off a shared counter in config
+ * order. Each worker keeps a single untraced, and so quiet, Simulator
+ * around and resets it for every task, so a replica costs no allocations
+ * once the queue and the network have grown to size.
+ */
+template<typename EventQueue>
+std::vector<SimulationResult> sweep(const std::vector<Config>& configs, int replicas,
+                                    unsigned long long master, int numThreads) {
+  long long numTasks = static_cast<long long>(configs.size()) * replicas;
+  std::vector<SimulationResult> results(numTasks);
+  std::atomic<long long> next(0);
+
+  auto work = [&]() {
+    Simulator<EventQueue> simulator(configs[0].numComputers, configs[0].attackProbability,
+                                    configs[0].detectProbability, 0);
+    long long task;
+    while ((task = next.fetch_add(1)) < numTasks) {
+      int config = task / replicas;
+      int replica = task % replicas;
+      const Config& c = configs[config];
+      simulator.reset(c.numComputers, c.attackProbability, c.detectProbability,
+                      replicaSeed(master, config, replica));
+      results[task] = simulator.simulate();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++) {
+    threads.emplace_back(work);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return results;
+}
+
+void report(const std::vector<Config>& configs, int replicas, const std::vector<SimulationResult>& results) {
+  std::cout << "computers,attack,detect,replicas,"
+            << "attacker_wins,attacker_rate,attacker_low,attacker_high,"
+            << "sysadmin_wins,sysadmin_rate,sysadmin_low,sysadmin_high,"
+            << "draws,draw_rate,draw_low,draw_high,"
+            << "mean_end_time,p50_end_time,p90_end_time,p99_end_time,mean_events" << std::endl;
+
+  for (size_t config = 0; config < configs.size(); config++) {
+    int counts[4] = {0, 0, 0, 0};
+    double totalTime = 0;
+    double totalEvents = 0;
+    std::vector<long long> endTimes;
+    endTimes.reserve(replicas);
+    for (int replica = 0; replica < replicas; replica++) {
+      const SimulationResult& r = results[config * replicas + replica];
+      counts[r.outcome]++;
+      totalTime += r.endTime;
+      totalEvents += r.events;
+      endTimes.push_back(r.endTime);
+    }
+    if (counts[QUEUE_EMPTY] > 0) {
+      std::cerr << counts[QUEUE_EMPTY] << " replicas ran out of events. This is not intended." << std::endl;
+    }
+    std::sort(endTimes.begin(), endTimes.end());
+
+    const Config& c = configs[config];
+    std::cout << c.numComputers << "," << c.attackProbability << "," << c.detectProbability << "," << replicas;
+    END_CONDITIONS outcomes[3] = {NETWORK_CONQUERED, NETWORK_DEFENDED, TIMED_OUT};
+    for (END_CONDITIONS outcome : outcomes) {
+      double low, high;
+      wilson(counts[outcome], replicas, low, high);
+      std::cout << "," << counts[outcome] << "," << static_cast<double>(counts[outcome]) / replicas
+                << "," << low << "," << high;
+    }
+    std::cout << "," << totalTime / replicas << "," << percentile(endTimes, 0.5)
+              << "," << percentile(endTimes, 0.9) << "," << percentile(endTimes, 0.99)
+              << "," << totalEvents / replicas << std::endl;
+  }
+}
+
+void usage() {
+  std::cout << "Usage: sweep --computers=<list> --attack=<list> --detect=<list> "
+            << "[--replicas=<n>] [--seed=<n>] [--threads=<n>] [--queue=heap|calendar|radix|pairing]" << std::endl
+            << "Lists are comma separated, e.g. --computers=10,100,1000" << std::endl;
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  std::vector<int> computers, attack, detect;
+  int replicas = 100;
+  unsigned long long master = time(0);
+  int numThreads = std::thread::hardware_concurrency();
+  const char *queue = "heap";
+  for (int i = 1; i < argc; i++) {
+    bool ok = true;
+    if (strncmp(argv[i], "--computers=", 12) == 0) {
+      ok = parseList(argv[i] + 12, computers);
+    } else if (strncmp(argv[i], "--attack=", 9) == 0) {
+      ok = parseList(argv[i] + 9, attack);
+    } else if (strncmp(argv[i], "--detect=", 9) == 0) {
+      ok = parseList(argv[i] + 9, detect);
+    } else if (strncmp(argv[i], "--replicas=", 11) == 0) {
+      replicas = atoi(argv[i] + 11);
+    } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+      master = strtoull(argv[i] + 7, nullptr, 10);
+    } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+      numThreads = atoi(argv[i] + 10);
+    } else if (strncmp(argv[i], "--queue=", 8) == 0) {
+      queue = argv[i] + 8;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "Bad argument: " << argv[i] << std::endl;
+      usage();
+    }
+  }
+  if (computers.empty() || attack.empty() || detect.empty() || replicas < 1) {
+    usage();
+  }
+  if (numThreads < 1) {  numThreads = 1;  }
+
+  std::vector<Config> configs;
+  for (int n : computers) {
+    for (int a : attack) {
+      for (int d : detect) {
+        if (n < 2) {
+          std::cerr << "Networks need at least two computers" << std::endl;
+          exit(1);
+        }
+        configs.push_back(Config{n, a, d});
+      }
+    }
+  }
+
+  std::vector<SimulationResult> results;
+  if (strcmp(queue, "heap") == 0) {
+    results = sweep<HeapEventQueue>(configs, replicas, master, numThreads);
+  } else if (strcmp(queue, "calendar") == 0) {
+    results = sweep<CalendarEventQueue>(configs, replicas, master, numThreads);
+  } else if (strcmp(queue, "radix") == 0) {
+    results = sweep<RadixEventQueue>(configs, replicas, master, numThreads);
+  } else if (strcmp(queue, "pairing") == 0) {
+    results = sweep<PairingEventQueue>(configs, replicas, master, numThreads);
+  } else {
+    std::cerr << "Unknown queue: " << queue << std::endl;
+    exit(1);
+  }
+  report(configs, replicas, results);
+}
@@ -0,0 +1,174 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+#include <cstdio>
+#include <cstring>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// The two layouts a topology file can have. A matrix is what the graph
+// generator prints: n rows of n weights, 0 meaning no link. An edge list
+// starts with "n m" followed by m lines "u v w [ids]", one per undirected
+// link of latency w, with ids 1 if the link runs through an IDS
+enum TOPOLOGY_FORMAT {TOPOLOGY_MATRIX, TOPOLOGY_EDGES};
+
+/*
+ * Network layout for the simulator in compressed sparse row form. The
+ * links out of computer c are the entries offsets[c] up to offsets[c+1] of
+ * the neighbor, weight and monitored arrays, so picking a random neighbor
+ * or looking at a link is a couple of array reads however big the network.
+ *
+ * Links whose IDS placement isn't given (all of them for a matrix) are
+ * monitored when they cross between the lower and upper half of the ids,
+ * which is where the simulator used to put its one IDS.
+ */
+class Topology {
+  private:
+    int size;
+    std::vector<int> offsets;
+    std::vector<int> neighbors;
+    std::vector<int> weights;
+    std::vector<char> monitored;
+
+    // Links as read from the file, before they are sorted into rows.
+    // A monitored flag of -1 means it wasn't given
+    struct Link {
+      int from;
+      int to;
+      int weight;
+      int monitored;
+    };
+    void build(int size, std::vector<Link>& links);
+    bool parseMatrix(const char *text);
+    bool parseEdges(const char *text);
+  public:
+    Topology() : size(0), offsets(1, 0) { }
+
+    // Both return false if the text or file isn't a valid topology
+    bool parse(const std::string& text, TOPOLOGY_FORMAT format);
+    bool load(const char *path, TOPOLOGY_FORMAT format);
+
+    int getSize() const {  return this->size;  }
+    int getDegree(int computer) const {  return this->offsets[computer + 1] - this->offsets[computer];  }
+    // Links are numbered from 0 to the number of links, grouped by computer
+    int getLink(int computer, int i) const {  return this->offsets[computer] + i;  }
+    int getNeighbor(int link) const {  return this->neighbors[link];  }
+    int getWeight(int link) const {  return this->weights[link];  }
+    bool isMonitored(int link) const {  return this->monitored[link] != 0;  }
+};
+
+/* build:
+ * Sorts the links into rows with a counting pass over the sources, so
+ * building takes linear time whatever order the links came in.
+ */
+inline void Topology::build(int size, std::vector<Link>& links) {
+  this->size = size;
+  this->offsets.assign(size + 1, 0);
+  for (Link& l : links) {
+    this->offsets[l.from + 1]++;
+  }
+  for (int c = 0; c < size; c++) {
+    this->offsets[c + 1] += this->offsets[c];
+  }
+  this->neighbors.resize(links.size());
+  this->weights.resize(links.size());
+  this->monitored.resize(links.size());
+  std::vector<int> next(this->offsets.begin(), this->offsets.end() - 1);
+  int split = size / 2;
+  for (Link& l : links) {
+    int link = next[l.from]++;
+    this->neighbors[link] = l.to;
+    this->weights[link] = l.weight;
+    this->monitored[link] = (l.monitored == -1) ? ((l.from >= split) != (l.to >= split)) : (l.monitored != 0);
+  }
+}
+
+// The number of computers is the number of entries in the first row
+inline bool Topology::parseMatrix(const char *text) {
+  int size = 0;
+  const char *p = text;
+  while (*p != '\0' && *p != '\n') {
+    char *end;
+    strtol(p, &end, 10);
+    if (end == p) {  break;  }
+    size++;
+    p = end;
+    while (*p == ' ' || *p == '\t' || *p == '\r') {  p++;  }
+  }
+  if (size == 0) {  return false;  }
+
+  std::vector<Link> links;
+  p = text;
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      char *end;
+      long weight = strtol(p, &end, 10);
+      if (end == p) {  return false;  }
+      p = end;
+      if (weight > 0 && i != j) {
+        links.push_back(Link{i, j, static_cast<int>(weight), -1});
+      }
+    }
+  }
+  this->build(size, links);
+  return true;
+}
+
+// Every line after the header is one link, and an optional fourth number
+// on it is the IDS flag. Links go both ways
+inline bool Topology::parseEdges(const char *text) {
+  char *end;
+  long size = strtol(text, &end, 10);
+  long numLinks = strtol(end, &end, 10);
+  if (size <= 0 || numLinks < 0) {  return false;  }
+
+  std::vector<Link> links;
+  links.reserve(2 * numLinks);
+  const char *p = end;
+  for (long i = 0; i < numLinks; i++) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {  p++;  }
+    const char *lineEnd = strchr(p, '\n');
+    if (lineEnd == nullptr) {  lineEnd = p + strlen(p);  }
+
+    // strtol would happily skip over the newline, so stop at it by hand
+    long values[4];
+    int count = 0;
+    while (count < 4) {
+      while (*p == ' ' || *p == '\t' || *p == '\r') {  p++;  }
+      if (p >= lineEnd) {  break;  }
+      values[count] = strtol(p, &end, 10);
+      if (end == p) {  return false;  }
+      p = end;
+      count++;
+    }
+    if (count < 3) {  return false;  }
+    p = lineEnd;
+    int u = values[0], v = values[1], w = values[2];
+    int ids = (count == 4) ? (values[3] != 0) : -1;
+    if (u < 0 || u >= size || v < 0 || v >= size || u == v || w <= 0) {  return false;  }
+    links.push_back(Link{u, v, w, ids});
+    links.push_back(Link{v, u, w, ids});
+  }
+  this->build(size, links);
+  return true;
+}
+
+inline bool Topology::parse(const std::string& text, TOPOLOGY_FORMAT format) {
+  return (format == TOPOLOGY_MATRIX) ? this->parseMatrix(text.c_str()) : this->parseEdges(text.c_str());
+}
+
+// Reads the whole file in one go and parses it in memory
+inline bool Topology::load(const char *path, TOPOLOGY_FORMAT format) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {  return false;  }
+  std::string text;
+  char chunk[1 << 16];
+  size_t got;
+  while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    text.append(chunk, got);
+  }
+  fclose(file);
+  return this->parse(text, format);
+}
+
+#endif
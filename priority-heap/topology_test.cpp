@@ -0,0 +1,47 @@
+#include "topology.hpp"
+#include <iostream>
+
+// Checks that a computer's links go to exactly the given neighbors with
+// the given weights and IDS flags, in order
+bool checkLinks(Topology& t, int computer, int degree, const int *neighbors, const int *weights, const bool *ids) {
+  if (t.getDegree(computer) != degree) {  return false;  }
+  for (int i = 0; i < degree; i++) {
+    int link = t.getLink(computer, i);
+    if (t.getNeighbor(link) != neighbors[i] || t.getWeight(link) != weights[i] || t.isMonitored(link) != ids[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  // Generator style output, with the padding and trailing spaces it prints
+  Topology matrix;
+  bool parsed = matrix.parse("  0  40   0  12 \n"
+                             " 40   0   7   0 \n"
+                             "  0   7   0  55 \n"
+                             " 12   0  55   0 \n", TOPOLOGY_MATRIX);
+  int n0[] = {1, 3}, w0[] = {40, 12};
+  bool i0[] = {false, true};
+  int n2[] = {1, 3}, w2[] = {7, 55};
+  bool i2[] = {true, false};
+  std::cout << "MATRIX: " << ((parsed && matrix.getSize() == 4 && checkLinks(matrix, 0, 2, n0, w0, i0) &&
+                                checkLinks(matrix, 2, 2, n2, w2, i2)) ? "LOADED" : "WRONG") << std::endl;
+
+  // Links go both ways, and the IDS column is optional
+  Topology edges;
+  parsed = edges.parse("5 4\n0 1 30 1\n1 2 20\n\n3 4 10 0\n0 4 99 1\n", TOPOLOGY_EDGES);
+  int e0[] = {1, 4}, v0[] = {30, 99};
+  bool d0[] = {true, true};
+  int e4[] = {3, 0}, v4[] = {10, 99};
+  bool d4[] = {false, true};
+  int e2[] = {1}, v2[] = {20};
+  bool d2[] = {true};
+  std::cout << "EDGES: " << ((parsed && edges.getSize() == 5 && checkLinks(edges, 0, 2, e0, v0, d0) &&
+                               checkLinks(edges, 4, 2, e4, v4, d4) && checkLinks(edges, 2, 1, e2, v2, d2)) ? "LOADED" : "WRONG") << std::endl;
+
+  Topology bad;
+  bool rejected = !bad.parse("3 2\n0 1 5\n", TOPOLOGY_EDGES) && !bad.parse("3 1\n0 3 5\n", TOPOLOGY_EDGES) &&
+                  !bad.parse("2 1\n0 1\n", TOPOLOGY_EDGES) && !bad.parse("0 1\n0\n", TOPOLOGY_MATRIX);
+  std::cout << "MALFORMED: " << (rejected ? "REJECTED" : "ACCEPTED") << std::endl;
+}
@@ -0,0 +1,205 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// How the events of a run get written out. Quiet writes nothing, text
+// writes the usual one line per event and binary writes fixed width records
+enum TRACE_MODE {TRACE_QUIET, TRACE_TEXT, TRACE_BINARY};
+
+// Size of each buffer handed to the writer thread, and how many full
+// buffers can be waiting on it before the simulation has to wait instead
+const size_t TRACE_BUFFER_BYTES = 1 << 20;
+const size_t TRACE_MAX_PENDING = 4;
+
+/*
+ * Binary traces start with a 16 byte header: the magic "SIMTRACE", the
+ * format version and the record size, both as 32 bit ints. Then come the
+ * records, 20 bytes each: the time as a 64 bit int followed by the action,
+ * source and target as 32 bit ints. Everything is in the byte order of the
+ * machine that wrote the trace.
+ */
+const char TRACE_MAGIC[8] = {'S', 'I', 'M', 'T', 'R', 'A', 'C', 'E'};
+const int TRACE_VERSION = 1;
+const int TRACE_HEADER_BYTES = 16;
+const int TRACE_RECORD_BYTES = 20;
+
+struct TraceRecord {
+  long long time;
+  int action;
+  int source;
+  int target;
+
+  void encode(char *out) const {
+    memcpy(out, &this->time, 8);
+    memcpy(out + 8, &this->action, 4);
+    memcpy(out + 12, &this->source, 4);
+    memcpy(out + 16, &this->target, 4);
+  }
+  static TraceRecord decode(const char *in) {
+    TraceRecord r;
+    memcpy(&r.time, in, 8);
+    memcpy(&r.action, in + 8, 4);
+    memcpy(&r.source, in + 12, 4);
+    memcpy(&r.target, in + 16, 4);
+    return r;
+  }
+};
+
+/*
+ * Writes a trace to a file descriptor through large buffers. The caller
+ * appends to the current buffer; once it is full it is handed over to a
+ * background thread that does the actual write() calls, and the caller
+ * carries on with a spare buffer. So the simulation never waits on I/O
+ * unless the disk falls more than a few buffers behind.
+ *
+ * The writer does not own the descriptor. flush waits until everything
+ * appended so far has been written, and the destructor flushes. If a
+ * write fails the rest of the trace is dropped, and flush returns false
+ * from then on with the errno left in getError. Quiet traces never start
+ * the writer thread at all.
+ */
+class TraceWriter {
+  private:
+    TRACE_MODE mode;
+    int fd;
+    size_t bufferBytes;
+    std::vector<char> current;
+
+    // Shared with the writer thread, under the mutex
+    std::deque<std::vector<char>> full;
+    std::vector<std::vector<char>> spare;
+    bool writing;
+    bool stopping;
+    int error;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::thread writer;
+
+    void handOff();
+    void drain();
+    int writeAll(const char *bytes, size_t length);
+  public:
+    TraceWriter(TRACE_MODE mode, int fd, size_t bufferBytes = TRACE_BUFFER_BYTES);
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter();
+
+    TRACE_MODE getMode() {  return this->mode;  }
+    int getError();
+
+    void write(const char *bytes, size_t length) {
+      if (this->mode == TRACE_QUIET) {  return;  }
+      if (this->current.size() + length > this->bufferBytes) {  this->handOff();  }
+      this->current.insert(this->current.end(), bytes, bytes + length);
+    }
+    void record(long long time, int action, int source, int target) {
+      char bytes[TRACE_RECORD_BYTES];
+      TraceRecord{time, action, source, target}.encode(bytes);
+      this->write(bytes, TRACE_RECORD_BYTES);
+    }
+    bool flush();
+};
+
+inline TraceWriter::TraceWriter(TRACE_MODE mode, int fd, size_t bufferBytes)
+  : mode(mode), fd(fd), bufferBytes(bufferBytes), writing(false), stopping(false), error(0) {
+  if (this->mode == TRACE_QUIET) {  return;  }
+  this->current.reserve(this->bufferBytes);
+  if (this->mode == TRACE_BINARY) {
+    char header[TRACE_HEADER_BYTES];
+    memcpy(header, TRACE_MAGIC, 8);
+    memcpy(header + 8, &TRACE_VERSION, 4);
+    memcpy(header + 12, &TRACE_RECORD_BYTES, 4);
+    this->write(header, TRACE_HEADER_BYTES);
+  }
+  this->writer = std::thread(&TraceWriter::drain, this);
+}
+
+inline TraceWriter::~TraceWriter() {
+  this->flush();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->wake.notify_one();
+  if (this->writer.joinable()) {  this->writer.join();  }
+}
+
+/* handOff:
+ * Queues the current buffer for the writer thread and takes a spare one
+ * to carry on with. Blocks only while too many buffers are still pending.
+ */
+inline void TraceWriter::handOff() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->full.push_back(std::move(this->current));
+  this->wake.notify_one();
+  this->drained.wait(lock, [this] {
+    return !this->spare.empty() || this->full.size() < TRACE_MAX_PENDING;
+  });
+  if (!this->spare.empty()) {
+    this->current = std::move(this->spare.back());
+    this->spare.pop_back();
+  } else {
+    this->current = std::vector<char>();
+    this->current.reserve(this->bufferBytes);
+  }
+}
+
+// True if everything traced so far made it out
+inline bool TraceWriter::flush() {
+  if (!this->current.empty()) {  this->handOff();  }
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->drained.wait(lock, [this] {  return this->full.empty() && !this->writing;  });
+  return this->error == 0;
+}
+
+inline int TraceWriter::getError() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->error;
+}
+
+// Body of the writer thread. Writes full buffers in order and recycles
+// them as spares until it is told to stop. After the first failed write
+// the buffers are still recycled but no longer written
+inline void TraceWriter::drain() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true) {
+    this->wake.wait(lock, [this] {  return this->stopping || !this->full.empty();  });
+    if (this->full.empty()) {  return;  }
+    std::vector<char> buffer = std::move(this->full.front());
+    this->full.pop_front();
+    this->writing = true;
+    bool failed = this->error != 0;
+    lock.unlock();
+    int error = failed ? 0 : this->writeAll(buffer.data(), buffer.size());
+    buffer.clear();
+    lock.lock();
+    if (error != 0) {  this->error = error;  }
+    this->writing = false;
+    this->spare.push_back(std::move(buffer));
+    this->drained.notify_all();
+  }
+}
+
+// write() may take less than it is given, so keep going until it is all
+// out. Returns the errno of the write that failed, or 0
+inline int TraceWriter::writeAll(const char *bytes, size_t length) {
+  while (length > 0) {
+    ssize_t written = ::write(this->fd, bytes, length);
+    if (written < 0 && errno == EINTR) {  continue;  }
+    if (written < 0) {  return errno;  }
+    if (written == 0) {  return EIO;  }
+    bytes += written;
+    length -= written;
+  }
+  return 0;
+}
+
+#endif
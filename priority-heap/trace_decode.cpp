@@ -0,0 +1,81 @@
+#include "simulator.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+/*
+ * Turns a binary trace written by `simulator --trace=binary` back into the
+ * text the simulator prints, one Deploy_Attack(t, s, d) style line per
+ * record. Reads the file (or stdin) and writes stdout in large chunks.
+ */
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    std::cout << "Usage: trace_decode [<trace_file>]" << std::endl;
+    exit(1);
+  }
+  FILE *in = (argc == 2) ? fopen(argv[1], "rb") : stdin;
+  if (in == nullptr) {
+    std::cerr << "Could not open " << argv[1] << std::endl;
+    exit(1);
+  }
+
+  char header[TRACE_HEADER_BYTES];
+  int version, recordBytes;
+  if (fread(header, 1, TRACE_HEADER_BYTES, in) != static_cast<size_t>(TRACE_HEADER_BYTES) ||
+      memcmp(header, TRACE_MAGIC, 8) != 0) {
+    std::cerr << "Not a simulator trace" << std::endl;
+    exit(1);
+  }
+  memcpy(&version, header + 8, 4);
+  memcpy(&recordBytes, header + 12, 4);
+  if (version != TRACE_VERSION || recordBytes != TRACE_RECORD_BYTES) {
+    std::cerr << "Unsupported trace version " << version << std::endl;
+    exit(1);
+  }
+
+  const size_t recordsPerChunk = TRACE_BUFFER_BYTES / TRACE_RECORD_BYTES;
+  std::vector<char> records(recordsPerChunk * TRACE_RECORD_BYTES);
+  std::vector<char> text;
+  text.reserve(recordsPerChunk * TRACE_LINE_BYTES);
+  size_t leftover = 0;
+  long long decoded = 0;
+  while (true) {
+    size_t got = fread(records.data() + leftover, 1, records.size() - leftover, in);
+    size_t available = leftover + got;
+    size_t complete = available / TRACE_RECORD_BYTES;
+    if (complete == 0) {
+      leftover = available;
+      break;
+    }
+
+    text.clear();
+    char line[TRACE_LINE_BYTES];
+    for (size_t i = 0; i < complete; i++) {
+      TraceRecord r = TraceRecord::decode(records.data() + i * TRACE_RECORD_BYTES);
+      Event e{static_cast<ACTION>(r.action), r.source, r.target, -1, 0};
+      int length = formatEvent(line, r.time, e);
+      // A record with no such action means the file is corrupt, so don't
+      // pass off what is left of it as a shorter trace
+      if (length == 0) {
+        fwrite(text.data(), 1, text.size(), stdout);
+        fflush(stdout);
+        std::cerr << "Record " << decoded << " has an unknown action " << r.action << std::endl;
+        exit(1);
+      }
+      text.insert(text.end(), line, line + length);
+      decoded++;
+    }
+    fwrite(text.data(), 1, text.size(), stdout);
+
+    leftover = available - complete * TRACE_RECORD_BYTES;
+    memmove(records.data(), records.data() + complete * TRACE_RECORD_BYTES, leftover);
+    if (got == 0) {  break;  }
+  }
+  if (leftover != 0) {
+    std::cerr << "Trace ends in the middle of a record" << std::endl;
+    exit(1);
+  }
+  if (in != stdin) {  fclose(in);  }
+}